@@ -0,0 +1,37 @@
+#include "tests/libexpr.hh"
+
+#include "eval-profiler.hh"
+#include "file-system.hh"
+
+namespace nix {
+
+    TEST_F(LibExprTest, evalProfilerWritesCollapsedStacks) {
+        Path tmpDir = createTempDir();
+        AutoDelete delTmpDir(tmpDir);
+        auto profileFile = tmpDir + "/nix.profile";
+
+        state.profiler = std::make_unique<EvalProfiler>(state, profileFile, 10000);
+
+        auto v = eval(R"(
+            let
+              step = acc: x: acc + x;
+            in builtins.foldl' step 0 (builtins.genList (x: x) 200000)
+        )");
+        ASSERT_THAT(v, IsIntEq(19999900000));
+
+        state.profiler.reset();
+
+        auto lines = tokenizeString<std::vector<std::string>>(readFile(profileFile), "\n");
+        ASSERT_FALSE(lines.empty());
+        for (auto & line : lines) {
+            auto space = line.rfind(' ');
+            ASSERT_NE(space, std::string::npos);
+            ASSERT_TRUE(string2Int<uint64_t>(line.substr(space + 1)));
+        }
+
+        auto profile = readFile(profileFile);
+        ASSERT_THAT(profile, testing::HasSubstr("foldl';«string»:3:"));
+        ASSERT_THAT(profile, testing::HasSubstr(":step "));
+    }
+
+} /* namespace nix */
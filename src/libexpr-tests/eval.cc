@@ -161,4 +161,27 @@ TEST_F(EvalStateTest, getBuiltin_fail) {
     ASSERT_THROW(state.getBuiltin("nonexistent"), EvalError);
 }
 
+TEST_F(EvalStateTest, countAllocations) {
+    state.countAllocs = true;
+
+    auto v = eval(R"(
+        let
+          f = n: builtins.genList (x: { inherit x; }) n;
+        in builtins.length (f 1000)
+    )", true);
+    ASSERT_THAT(v, IsIntEq(1000));
+
+    std::optional<EvalState::AllocationStats> fStats;
+    for (auto & [pos, stats] : state.allocationSites) {
+        auto p = state.positions[pos];
+        if (p.line == 3 && p.column == 15) fStats = stats;
+    }
+
+    /* `f` allocates its environment and the list; the attribute sets
+       are allocated by the inner lambda. */
+    ASSERT_TRUE(fStats);
+    ASSERT_GE(fStats->bytes, 1000 * sizeof(Value *));
+    ASSERT_GE(state.allocationSites[noPos].count, 1);
+}
+
 } // namespace nix
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include "eval.hh"
+#include "eval-gc.hh"
+#include "eval-settings.hh"
+#include "environment-variables.hh"
+#include "fetch-settings.hh"
+#include "file-system.hh"
+#include "parse-cache.hh"
+#include "store-api.hh"
+
+namespace nix {
+
+/**
+ * Return a Nix file with `nrAttrs` attributes that uses most kinds
+ * of expressions.
+ */
+static std::string makeNixFile(size_t nrAttrs)
+{
+    std::string s = "{ lib, pkgs }:\nrec {\n";
+    for (size_t n = 0; n < nrAttrs; ++n)
+        s += fmt(
+            "  attr%1% = { x ? %1%, ... }@args: with args; let y = x + 1; in\n"
+            "    if y > 10 then [ y \"str-${toString y}\" ./file%1% ] else { inherit (pkgs) foo; z = pkgs.bar or y; };\n",
+            n);
+    s += "}\n";
+    return s;
+}
+
+/**
+ * Parse a file with `EvalState::parseExprFromFile()`, with or without
+ * the parse cache. Argument: number of attributes in the file.
+ */
+static void parseFile(benchmark::State & state, bool useCache)
+{
+    auto tmpDir = createTempDir();
+    AutoDelete delTmpDir(tmpDir);
+    setEnv("NIX_CACHE_HOME", (tmpDir + "/cache").c_str());
+
+    auto path = tmpDir + "/default.nix";
+    writeFile(path, makeNixFile(state.range(0)));
+
+    bool readOnlyMode = true;
+    fetchers::Settings fetchSettings;
+    EvalSettings evalSettings{readOnlyMode};
+    evalSettings.parseCache = useCache;
+    EvalState evalState({}, openStore("dummy://"), fetchSettings, evalSettings, nullptr);
+
+    auto sourcePath = evalState.rootPath(CanonPath(path));
+
+    /* Fill the cache. */
+    evalState.parseExprFromFile(sourcePath);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(evalState.parseExprFromFile(sourcePath));
+
+    state.SetBytesProcessed(state.iterations() * readFile(path).size());
+
+    unsetenv("NIX_CACHE_HOME");
+}
+
+static void BM_ParseUncached(benchmark::State & state)
+{
+    parseFile(state, false);
+}
+
+static void BM_ParseCached(benchmark::State & state)
+{
+    parseFile(state, true);
+}
+
+BENCHMARK(BM_ParseUncached)
+    ->ArgName("attrs")
+    ->Arg(100)
+    ->Arg(10000);
+
+BENCHMARK(BM_ParseCached)
+    ->ArgName("attrs")
+    ->Arg(100)
+    ->Arg(10000);
+
+}
+
+int main(int argc, char ** argv)
+{
+    nix::initLibStore(false);
+    nix::initGC();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
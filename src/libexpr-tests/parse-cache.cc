@@ -0,0 +1,124 @@
+#include "tests/libexpr.hh"
+
+#include "parse-cache.hh"
+#include "file-system.hh"
+#include "environment-variables.hh"
+
+namespace nix {
+
+    class ParseCacheTest : public LibExprTest
+    {
+    protected:
+        Path tmpDir;
+        AutoDelete delTmpDir;
+
+        ParseCacheTest()
+            : tmpDir(createTempDir())
+            , delTmpDir(tmpDir)
+        {
+            setEnv("NIX_CACHE_HOME", (tmpDir + "/cache").c_str());
+            evalSettings.parseCache = true;
+        }
+
+        ~ParseCacheTest()
+        {
+            unsetenv("NIX_CACHE_HOME");
+        }
+
+        SourcePath writeNixFile(std::string_view contents)
+        {
+            auto path = tmpDir + "/default.nix";
+            writeFile(path, contents);
+            return state.rootPath(CanonPath(path));
+        }
+
+        std::string show(Expr * e)
+        {
+            std::ostringstream out;
+            e->show(state.symbols, out);
+            return out.str();
+        }
+    };
+
+    TEST_F(ParseCacheTest, roundTrip) {
+        auto path = writeNixFile(R"(
+            let
+              /** Adds one. */
+              inc = x: x + 1;
+              src = { a = 1; b = "b"; };
+            in rec {
+              inherit (src) a b;
+              c = inc a;
+              d = [ ./foo "${b}c" ~/bar 1.5 ];
+              e = { x, y ? c, ... }@args: with args; if x > y then x else assert y != null; y;
+              f = src ? a && !(src ? "z") || src.b or null == "b";
+              ${"dyn"} = __curPos;
+              g = a: b: a // b ++ [ ];
+            }
+        )");
+
+        auto e1 = state.parseExprFromFile(path);
+        auto cachePath = getParseCachePath(path, readFile(path.path.abs()) + std::string("\0\0", 2), evalSettings);
+        ASSERT_TRUE(pathExists(cachePath));
+
+        auto e2 = state.parseExprFromFile(path);
+        ASSERT_NE(e1, e2);
+        ASSERT_EQ(show(e1), show(e2));
+
+        auto let = dynamic_cast<ExprLet *>(e2);
+        ASSERT_TRUE(let);
+        auto inc = dynamic_cast<ExprLambda *>(let->attrs->attrs.at(createSymbol("inc")).e);
+        ASSERT_TRUE(inc);
+        ASSERT_TRUE(inc->docComment);
+        ASSERT_THAT(inc->docComment.getInnerText(state.positions), testing::HasSubstr("Adds one."));
+    }
+
+    TEST_F(ParseCacheTest, evalFromCache) {
+        auto path = writeNixFile("let f = { a, b ? 2 }: a * b; in f { a = 21; }");
+
+        Value v1;
+        state.evalFile(path, v1);
+        state.forceValue(v1, noPos);
+        ASSERT_THAT(v1, IsIntEq(42));
+
+        state.resetFileCache();
+
+        Value v2;
+        state.evalFile(path, v2);
+        state.forceValue(v2, noPos);
+        ASSERT_THAT(v2, IsIntEq(42));
+    }
+
+    TEST_F(ParseCacheTest, corruptEntryIsIgnored) {
+        auto path = writeNixFile("[ 1 2 3 ]");
+        auto cachePath = getParseCachePath(path, readFile(path.path.abs()) + std::string("\0\0", 2), evalSettings);
+
+        createDirs(dirOf(cachePath));
+        writeFile(cachePath, "nix-parse-cache\ngarbage");
+
+        auto v = state.allocValue();
+        state.eval(state.parseExprFromFile(path), *v);
+        ASSERT_THAT(*v, IsListOfSize(3));
+    }
+
+    TEST_F(ParseCacheTest, pruneLeastRecentlyUsed) {
+        auto dir = tmpDir + "/entries";
+        std::string data(400, 'x');
+
+        writeParseCacheEntry(dir + "/a", data, 1000);
+        writeParseCacheEntry(dir + "/b", data, 1000);
+        setWriteTime(dir + "/a", 1000, 1000);
+        setWriteTime(dir + "/b", 2000, 2000);
+
+        /* Reading `a` makes `b` the least recently used entry. */
+        ASSERT_EQ(readParseCacheEntry(dir + "/a"), data);
+
+        writeParseCacheEntry(dir + "/c", data, 1000);
+        ASSERT_TRUE(pathExists(dir + "/a"));
+        ASSERT_FALSE(pathExists(dir + "/b"));
+        ASSERT_TRUE(pathExists(dir + "/c"));
+
+        ASSERT_EQ(readParseCacheEntry(dir + "/b"), std::nullopt);
+    }
+
+} /* namespace nix */
@@ -62,15 +62,89 @@ namespace nix {
     TEST_F(TrivialExpressionTest, updateAttrs) {
         auto v = eval("{ a = 1; } // { b = 2; a = 3; }");
         ASSERT_THAT(v, IsAttrsOfSize(2));
-        auto a = v.attrs()->find(createSymbol("a"));
+        auto a = v.attrs()->get(createSymbol("a"));
         ASSERT_NE(a, nullptr);
         ASSERT_THAT(*a->value, IsIntEq(3));
 
-        auto b = v.attrs()->find(createSymbol("b"));
+        auto b = v.attrs()->get(createSymbol("b"));
         ASSERT_NE(b, nullptr);
         ASSERT_THAT(*b->value, IsIntEq(2));
     }
 
+    TEST_F(TrivialExpressionTest, updateAttrsLayered) {
+        auto v = eval(R"(
+            let
+              base = builtins.listToAttrs (builtins.genList (n: { name = "a${toString n}"; value = n; }) 32);
+            in base // { a3 = "x"; b = 1; }
+        )");
+        ASSERT_THAT(v, IsAttrsOfSize(33));
+        ASSERT_EQ(v.attrs()->numLayers(), 2);
+
+        auto a3 = v.attrs()->get(createSymbol("a3"));
+        ASSERT_NE(a3, nullptr);
+        ASSERT_THAT(*a3->value, IsStringEq("x"));
+
+        auto a4 = v.attrs()->get(createSymbol("a4"));
+        ASSERT_NE(a4, nullptr);
+        ASSERT_THAT(*a4->value, IsIntEq(4));
+
+        auto i = v.attrs()->find(createSymbol("a4"));
+        ASSERT_TRUE(i != v.attrs()->end());
+        ASSERT_EQ(&*i, a4);
+        ASSERT_TRUE(v.attrs()->find(createSymbol("c")) == v.attrs()->end());
+
+        size_t n = 0;
+        std::optional<Symbol> prev;
+        for (auto & attr : *v.attrs()) {
+            if (prev) { ASSERT_LT(*prev, attr.name); }
+            prev = attr.name;
+            const Bindings & attrs = *v.attrs();
+            ASSERT_EQ(&attrs[n], &attr);
+            n++;
+        }
+        ASSERT_EQ(n, 33);
+    }
+
+    TEST_F(TrivialExpressionTest, updateAttrsLayeredMatchesMerge) {
+        auto v = eval(R"(
+            let
+              base = builtins.listToAttrs (builtins.genList (n: { name = "a${toString n}"; value = n; }) 64);
+              layered = builtins.foldl' (s: n: s // { "a${toString (n * 3)}" = -n; "b${toString n}" = n; }) base (builtins.genList (n: n) 12);
+            in layered == builtins.listToAttrs (map (name: { inherit name; value = layered.${name}; }) (builtins.attrNames layered))
+              && builtins.length (builtins.attrNames layered) == 76
+              && layered.a33 == -11
+              && layered.a34 == 34
+        )");
+        ASSERT_THAT(v, IsTrue());
+    }
+
+    TEST_F(TrivialExpressionTest, concatListsInFold) {
+        auto v = eval(R"(
+            let
+              xs = builtins.genList (n: n) 100;
+              acc = builtins.foldl' (acc: x: acc ++ [ x ]) [ ] xs;
+              nested = builtins.concatLists [ acc (acc ++ acc) [ ] acc ];
+            in acc == xs
+              && builtins.length nested == 400
+              && builtins.elemAt nested 257 == 57
+              && builtins.map (x: x * 2) acc == builtins.genList (n: n * 2) 100
+              && builtins.filter (x: x < 3) nested == [ 0 1 2 0 1 2 0 1 2 0 1 2 ]
+              && builtins.foldl' builtins.add 0 nested == 19800
+        )");
+        ASSERT_THAT(v, IsTrue());
+    }
+
+    TEST_F(TrivialExpressionTest, selectFromSetsOfDifferentShapes) {
+        auto v = eval(R"(
+            let
+              sets = [ { a = 1; b = 2; } { b = 3; } { c = 4; } { a = 5; b = 6; } { b = 7; c = 8; } ];
+            in builtins.map (s: [ (s.b or 0) (s ? b) ]) sets
+        )");
+        ASSERT_THAT(v, IsListOfSize(5));
+        auto expected = eval("[ [ 2 true ] [ 3 true ] [ 0 false ] [ 6 true ] [ 7 true ] ]");
+        ASSERT_TRUE(state.eqValues(v, expected, noPos, ""));
+    }
+
     TEST_F(TrivialExpressionTest, hasAttrOpFalse) {
         auto v = eval("{} ? a");
         ASSERT_THAT(v, IsFalse());
@@ -151,7 +225,7 @@ namespace nix {
         auto v = eval(expr);
         ASSERT_THAT(v, IsAttrsOfSize(1));
 
-        auto a = v.attrs()->find(createSymbol("a"));
+        auto a = v.attrs()->get(createSymbol("a"));
         ASSERT_NE(a, nullptr);
 
         ASSERT_THAT(*a->value, IsThunk());
@@ -159,11 +233,11 @@ namespace nix {
 
         ASSERT_THAT(*a->value, IsAttrsOfSize(2));
 
-        auto b = a->value->attrs()->find(createSymbol("b"));
+        auto b = a->value->attrs()->get(createSymbol("b"));
         ASSERT_NE(b, nullptr);
         ASSERT_THAT(*b->value, IsIntEq(1));
 
-        auto c = a->value->attrs()->find(createSymbol("c"));
+        auto c = a->value->attrs()->get(createSymbol("c"));
         ASSERT_NE(c, nullptr);
         ASSERT_THAT(*c->value, IsIntEq(2));
     }
@@ -290,7 +364,7 @@ namespace nix {
     TEST_F(TrivialExpressionTest, bindOr) {
         auto v = eval("{ or = 1; }");
         ASSERT_THAT(v, IsAttrsOfSize(1));
-        auto b = v.attrs()->find(createSymbol("or"));
+        auto b = v.attrs()->get(createSymbol("or"));
         ASSERT_NE(b, nullptr);
         ASSERT_THAT(*b->value, IsIntEq(1));
     }
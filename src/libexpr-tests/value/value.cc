@@ -22,4 +22,60 @@ TEST_F(ValueTest, vInt)
     ASSERT_EQ(true, vInt.isValid());
 }
 
+TEST_F(ValueTest, size)
+{
+    ASSERT_EQ(sizeof(Value), 2 * sizeof(void *));
+}
+
+TEST_F(ValueTest, roundTrip)
+{
+    Value elems[3];
+    Value * elemPtrs[3] = {&elems[0], &elems[1], &elems[2]};
+
+    Value v;
+    v.mkInt(-1);
+    ASSERT_EQ(nInt, v.type());
+    ASSERT_EQ(-1, v.integer().value);
+
+    v.mkFloat(1.5);
+    ASSERT_EQ(nFloat, v.type());
+    ASSERT_EQ(1.5, v.fpoint());
+
+    v.mkBool(true);
+    ASSERT_EQ(nBool, v.type());
+    ASSERT_TRUE(v.boolean());
+
+    v.mkNull();
+    ASSERT_EQ(nNull, v.type());
+
+    const char * context[] = {"/nix/store/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa-foo", nullptr};
+    v.mkString("foo", context);
+    ASSERT_EQ(nString, v.type());
+    ASSERT_EQ("foo", v.string_view());
+    ASSERT_EQ(context, v.context());
+
+    v.mkString("bar");
+    ASSERT_EQ("bar", v.string_view());
+    ASSERT_EQ(nullptr, v.context());
+
+    v.mkApp(elemPtrs[0], elemPtrs[1]);
+    ASSERT_TRUE(v.isApp());
+    ASSERT_FALSE(v.isPrimOpApp());
+    ASSERT_EQ(nThunk, v.type());
+    ASSERT_EQ(elemPtrs[0], v.app().left);
+    ASSERT_EQ(elemPtrs[1], v.app().right);
+
+    v.mkPrimOpApp(elemPtrs[1], elemPtrs[2]);
+    ASSERT_FALSE(v.isApp());
+    ASSERT_TRUE(v.isPrimOpApp());
+    ASSERT_EQ(nFunction, v.type());
+    ASSERT_EQ(elemPtrs[1], v.primOpApp().left);
+    ASSERT_EQ(elemPtrs[2], v.primOpApp().right);
+
+    v.mkBlackhole();
+    ASSERT_TRUE(v.isThunk());
+    ASSERT_TRUE(v.isBlackhole());
+    ASSERT_EQ(nullptr, v.thunk().env);
+}
+
 } // namespace nix
@@ -2,6 +2,7 @@
 #include "eval-inline.hh"
 
 #include <algorithm>
+#include <array>
 
 
 namespace nix {
@@ -11,15 +12,17 @@ namespace nix {
 /* Allocate a new array of attributes for an attribute set with a specific
    capacity. The space is implicitly reserved after the Bindings
    structure. */
-Bindings * EvalState::allocBindings(size_t capacity)
+Bindings * EvalState::allocBindings(size_t capacity, bool layered)
 {
-    if (capacity == 0)
+    if (capacity == 0 && !layered)
         return &emptyBindings;
     if (capacity > std::numeric_limits<Bindings::size_t>::max())
         throw Error("attribute set of size %d is too big", capacity);
     nrAttrsets++;
     nrAttrsInAttrsets += capacity;
-    return new (allocBytes(sizeof(Bindings) + sizeof(Attr) * capacity)) Bindings((Bindings::size_t) capacity);
+    auto size = sizeof(Bindings) + sizeof(Attr) * capacity + (layered ? sizeof(Bindings::Layer) : 0);
+    if (countAllocs) [[unlikely]] countAllocation(size);
+    return new (allocBytes(size)) Bindings((Bindings::size_t) capacity);
 }
 
 
@@ -43,6 +46,57 @@ void Bindings::sort()
 }
 
 
+void Bindings::setBaseLayer(const Bindings & base)
+{
+    assert(numLayers_ == 1);
+    assert(base.numLayers_ < maxLayers);
+
+    auto & l = layer();
+    l.base = &base;
+    l.totalSize = base.size();
+    for (size_t n = 0; n < size_; ++n)
+        if (!base.get(attrs[n].name))
+            l.totalSize++;
+    l.index = nullptr;
+
+    numLayers_ = base.numLayers_ + 1;
+}
+
+
+const Attr * const * Bindings::flatIndex() const
+{
+    auto & l = layer();
+    if (!l.index) {
+        auto index = (const Attr * *) allocBytes(sizeof(Attr *) * l.totalSize);
+
+        /* Merge the layers. Where several layers have an attribute
+           of the same name, take the one from the topmost layer. */
+        struct Cursor
+        {
+            const Attr * cur, * end;
+        };
+        std::array<Cursor, maxLayers> cursors;
+        size_t numCursors = 0;
+        for (auto layer = this; layer; layer = layer->baseLayer())
+            cursors[numCursors++] = {layer->attrs, layer->attrs + layer->size_};
+
+        for (size_t n = 0; n < l.totalSize; ++n) {
+            const Attr * next = nullptr;
+            for (size_t c = 0; c < numCursors; ++c)
+                if (cursors[c].cur != cursors[c].end && (!next || cursors[c].cur->name < next->name))
+                    next = cursors[c].cur;
+            index[n] = next;
+            for (size_t c = 0; c < numCursors; ++c)
+                if (cursors[c].cur != cursors[c].end && cursors[c].cur->name == next->name)
+                    ++cursors[c].cur;
+        }
+
+        l.index = index;
+    }
+    return l.index;
+}
+
+
 Value & Value::mkAttrs(BindingsBuilder & bindings)
 {
     mkAttrs(bindings.finish());
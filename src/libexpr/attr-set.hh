@@ -43,6 +43,15 @@ static_assert(sizeof(Attr) == 2 * sizeof(uint32_t) + sizeof(Value *),
  * by its size and its capacity, the capacity being the number of Attr
  * elements allocated after this structure, while the size corresponds to
  * the number of elements already inserted in this structure.
+ *
+ * To make `//` cheap when a small set is merged into a large one,
+ * Bindings can be layered: a layer holds its own sorted attributes
+ * and points to the (immutable) `baseLayer` underneath it, whose
+ * attributes it shadows. Lookups search the layers from the top, and
+ * iteration merges the layers, so users see a single set sorted by
+ * name. The bookkeeping for this lives in a `Layer` after the
+ * attributes of layered sets only, so that it costs nothing for
+ * other sets.
  */
 class Bindings
 {
@@ -50,21 +59,116 @@ public:
     typedef uint32_t size_t;
     PosIdx pos;
 
+    /**
+     * The maximum number of layers in a set. `//` flattens its
+     * result once this is reached, which bounds the cost of lookups.
+     */
+    static constexpr size_t maxLayers = 8;
+
 private:
-    size_t size_, capacity_;
+    /**
+     * `size_` and `capacity_` describe the attributes in this
+     * layer. `numLayers_` fits in what would otherwise be padding.
+     */
+    size_t size_, capacity_, numLayers_ = 1;
     Attr attrs[0];
 
+    /**
+     * Stored after the attributes of sets allocated with
+     * `EvalState::allocBindings(capacity, true)`.
+     */
+    struct Layer
+    {
+        const Bindings * base;
+        /**
+         * The size of the set formed by all layers.
+         */
+        size_t totalSize;
+        /**
+         * The attributes of all layers in iteration order, built on
+         * the first iteration or positional access.
+         */
+        mutable const Attr * * index;
+    };
+
+    Layer & layer() const { return *(Layer *) (attrs + capacity_); }
+
+    const Bindings * baseLayer() const { return numLayers_ > 1 ? layer().base : nullptr; }
+
+    const Attr * const * flatIndex() const;
+
     Bindings(size_t capacity) : size_(0), capacity_(capacity) { }
     Bindings(const Bindings & bindings) = delete;
 
 public:
-    size_t size() const { return size_; }
+    size_t size() const { return numLayers_ > 1 ? layer().totalSize : size_; }
 
-    bool empty() const { return !size_; }
+    bool empty() const { return !size(); }
 
+    /**
+     * Number of layers in this set, including this one.
+     */
+    size_t numLayers() const { return numLayers_; }
+
+    /**
+     * Iterator over a set that is only a single layer. Only used
+     * while building a set.
+     */
     typedef Attr * iterator;
 
-    typedef const Attr * const_iterator;
+    /**
+     * Iterator over the attributes of all layers, in order of name.
+     * Where several layers have an attribute of the same name, only
+     * the one from the topmost layer is visited. For a single layer
+     * this is a plain pointer into the attributes. Layered sets are
+     * iterated through their flat index.
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Attr;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Attr *;
+        using reference = const Attr &;
+
+    private:
+        friend class Bindings;
+
+        /* `attr` is used for single-layer sets, `indexed` for
+           layered ones. The other one is null. */
+        const Attr * attr = nullptr;
+        const Attr * const * indexed = nullptr;
+
+        const_iterator(const Attr * attr) : attr(attr) { }
+
+        const_iterator(const Attr * const * indexed) : indexed(indexed) { }
+
+    public:
+        const_iterator() { }
+
+        reference operator *() const { return indexed ? **indexed : *attr; }
+
+        pointer operator ->() const { return indexed ? *indexed : attr; }
+
+        const_iterator & operator ++()
+        {
+            if (indexed) ++indexed; else ++attr;
+            return *this;
+        }
+
+        const_iterator operator ++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator ==(const const_iterator & other) const
+        {
+            return attr == other.attr && indexed == other.indexed;
+        }
+    };
 
     void push_back(const Attr & attr)
     {
@@ -72,51 +176,101 @@ public:
         attrs[size_++] = attr;
     }
 
+    /**
+     * Return an iterator to the attribute named `name`. On a layered
+     * set, this indexes the set first, so use get() if you don't need
+     * to iterate from there.
+     */
     const_iterator find(Symbol name) const
     {
         Attr key(name, 0);
-        const_iterator i = std::lower_bound(begin(), end(), key);
-        if (i != end() && i->name == name) return i;
-        return end();
+        if (numLayers_ == 1) {
+            auto end = attrs + size_;
+            auto i = std::lower_bound(attrs, end, key);
+            if (i != end && i->name == name) return const_iterator(i);
+        } else {
+            auto index = flatIndex(), end = index + layer().totalSize;
+            auto i = std::lower_bound(index, end, key,
+                [](const Attr * a, const Attr & b) { return *a < b; });
+            if (i != end && (*i)->name == name) return const_iterator(i);
+        }
+        return this->end();
     }
 
     const Attr * get(Symbol name) const
     {
         Attr key(name, 0);
-        const_iterator i = std::lower_bound(begin(), end(), key);
-        if (i != end() && i->name == name) return &*i;
+        for (auto layer = this; layer; layer = layer->baseLayer()) {
+            auto end = layer->attrs + layer->size_;
+            auto i = std::lower_bound(layer->attrs, end, key);
+            if (i != end && i->name == name) return i;
+        }
         return nullptr;
     }
 
-    iterator begin() { return &attrs[0]; }
-    iterator end() { return &attrs[size_]; }
+    /**
+     * Return the attribute at index `i` if it is named `name`. This
+     * is a cheap check for callers that remember where they found an
+     * attribute before. It always fails for layered sets.
+     */
+    const Attr * getAt(size_t i, Symbol name) const
+    {
+        if (numLayers_ == 1 && i < size_ && attrs[i].name == name) return &attrs[i];
+        return nullptr;
+    }
 
-    const_iterator begin() const { return &attrs[0]; }
-    const_iterator end() const { return &attrs[size_]; }
+    iterator begin() { assert(numLayers_ == 1); return &attrs[0]; }
+    iterator end() { assert(numLayers_ == 1); return &attrs[size_]; }
+
+    const_iterator begin() const
+    {
+        if (numLayers_ == 1) return const_iterator(attrs);
+        return const_iterator(flatIndex());
+    }
+
+    const_iterator end() const
+    {
+        if (numLayers_ == 1) return const_iterator(attrs + size_);
+        return const_iterator(flatIndex() + layer().totalSize);
+    }
 
     Attr & operator[](size_t pos)
     {
+        assert(numLayers_ == 1);
         return attrs[pos];
     }
 
+    /**
+     * Return the `pos`th attribute in iteration order. If the set has
+     * several layers, the first call (like the first iteration) takes
+     * linear time to index them.
+     */
     const Attr & operator[](size_t pos) const
     {
-        return attrs[pos];
+        if (numLayers_ == 1) return attrs[pos];
+        return *flatIndex()[pos];
     }
 
     void sort();
 
     size_t capacity() const { return capacity_; }
 
+    /**
+     * Put this set, which must have a single sorted layer and have
+     * been allocated with room for a `Layer`, on top of `base`. The
+     * attributes of this set shadow those of `base`.
+     */
+    void setBaseLayer(const Bindings & base);
+
     /**
      * Returns the attributes in lexicographically sorted order.
      */
     std::vector<const Attr *> lexicographicOrder(const SymbolTable & symbols) const
     {
         std::vector<const Attr *> res;
-        res.reserve(size_);
-        for (size_t n = 0; n < size_; n++)
-            res.emplace_back(&attrs[n]);
+        res.reserve(size());
+        for (auto & a : *this)
+            res.emplace_back(&a);
         std::sort(res.begin(), res.end(), [&](const Attr * a, const Attr * b) {
             std::string_view sa = symbols[a->name], sb = symbols[b->name];
             return sa < sb;
@@ -127,6 +281,10 @@ public:
     friend class EvalState;
 };
 
+static_assert(sizeof(Bindings) == 2 * sizeof(Value *),
+    "every attribute set starts with a Bindings, so keep it small. "
+    "put bookkeeping that only layered sets need in Bindings::Layer.");
+
 /**
  * A wrapper around Bindings that ensures that its always in sorted
  * order at the end. The only way to consume a BindingsBuilder is to
@@ -4,6 +4,12 @@
 #include "config-global.hh"
 #include "serialise.hh"
 #include "eval-gc.hh"
+#include "finally.hh"
+#include "logging.hh"
+
+#ifndef _WIN32
+#  include "processes.hh"
+#endif
 
 #if HAVE_BOEHMGC
 
@@ -50,6 +56,11 @@ static inline void initGCReal()
 
     GC_INIT();
 
+    /* `Value` stores its type in the low 3 bits of pointers, so
+       pointers at those offsets must keep objects alive. */
+    for (size_t offset = 1; offset < 8; ++offset)
+        GC_register_displacement(offset);
+
     GC_set_oom_fn(oomHandler);
 
     /* Set the initial heap size to something fairly big (25% of
@@ -114,4 +125,28 @@ void assertGCInitialized()
     assert(gcInitialised);
 }
 
+#ifndef _WIN32
+pid_t startEvalProcess(std::function<void()> fun)
+{
+#  if HAVE_BOEHMGC
+    /* Make sure the collector's locks and the marker threads are in a
+       consistent state in the child, which only has the forking
+       thread. */
+    GC_atfork_prepare();
+    Finally restoreGC([]() { GC_atfork_parent(); });
+#  endif
+
+    return startProcess([&]() {
+#  if HAVE_BOEHMGC
+        GC_atfork_child();
+#  endif
+        /* The parent's logger may be a progress bar whose lock was
+           held by its update thread at the time of the fork. Never
+           touch it in the child. */
+        logger = makeSimpleLogger(false);
+        fun();
+    });
+}
+#endif
+
 } // namespace nix
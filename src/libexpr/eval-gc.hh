@@ -2,6 +2,11 @@
 ///@file
 
 #include <cstddef>
+#include <functional>
+
+#ifndef _WIN32
+#  include <sys/types.h>
+#endif
 
 #if HAVE_BOEHMGC
 
@@ -50,4 +55,14 @@ void assertGCInitialized();
 size_t getGCCycles();
 #endif
 
+#ifndef _WIN32
+/**
+ * Fork a child process that continues evaluating with a copy of the
+ * parent's heap, running `fun` in it. Like `startProcess()`, `fun`
+ * must end the child with `_exit()`. The child logs to stderr with a
+ * simple logger of its own.
+ */
+pid_t startEvalProcess(std::function<void()> fun);
+#endif
+
 } // namespace nix
@@ -48,6 +48,7 @@ Value * EvalState::allocValue()
 #endif
 
     nrValues++;
+    if (countAllocs) [[unlikely]] countAllocation(sizeof(Value));
     return (Value *) p;
 }
 
@@ -57,6 +58,7 @@ Env & EvalState::allocEnv(size_t size)
 {
     nrEnvs++;
     nrValuesInEnvs += size;
+    if (countAllocs) [[unlikely]] countAllocation(sizeof(Env) + size * sizeof(Value *));
 
     Env * env;
 
@@ -86,9 +88,9 @@ Env & EvalState::allocEnv(size_t size)
 void EvalState::forceValue(Value & v, const PosIdx pos)
 {
     if (v.isThunk()) {
-        Env * env = v.payload.thunk.env;
+        Env * env = v.thunk().env;
         assert(env || v.isBlackhole());
-        Expr * expr = v.payload.thunk.expr;
+        Expr * expr = v.thunk().expr;
         try {
             v.mkBlackhole();
             //checkInterrupt();
@@ -103,7 +105,7 @@ void EvalState::forceValue(Value & v, const PosIdx pos)
         }
     }
     else if (v.isApp())
-        callFunction(*v.payload.app.left, *v.payload.app.right, v, pos);
+        callFunction(*v.app().left, *v.app().right, v, pos);
 }
 
 
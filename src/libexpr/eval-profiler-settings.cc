@@ -0,0 +1,32 @@
+#include "eval-profiler-settings.hh"
+#include "args.hh"
+#include "logging.hh"
+#include "abstract-setting-to-json.hh"
+#include "config-impl.hh"
+
+#include <nlohmann/json.hpp>
+
+namespace nix {
+
+NLOHMANN_JSON_SERIALIZE_ENUM(EvalProfilerMode, {
+    {EvalProfilerMode::disabled, "disabled"},
+    {EvalProfilerMode::flamegraph, "flamegraph"},
+});
+
+template<> EvalProfilerMode BaseSetting<EvalProfilerMode>::parse(const std::string & str) const
+{
+    if (str == "disabled") return EvalProfilerMode::disabled;
+    else if (str == "flamegraph") return EvalProfilerMode::flamegraph;
+    else throw UsageError("option '%s' has invalid value '%s'", name, str);
+}
+
+template<> std::string BaseSetting<EvalProfilerMode>::to_string() const
+{
+    if (value == EvalProfilerMode::disabled) return "disabled";
+    else if (value == EvalProfilerMode::flamegraph) return "flamegraph";
+    else unreachable();
+}
+
+template class BaseSetting<EvalProfilerMode>;
+
+}
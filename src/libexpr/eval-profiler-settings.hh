@@ -0,0 +1,16 @@
+#pragma once
+///@file
+
+#include "config.hh"
+
+namespace nix {
+
+enum struct EvalProfilerMode {
+    disabled,
+    flamegraph,
+};
+
+template<> EvalProfilerMode BaseSetting<EvalProfilerMode>::parse(const std::string & str) const;
+template<> std::string BaseSetting<EvalProfilerMode>::to_string() const;
+
+}
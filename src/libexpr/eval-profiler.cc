@@ -0,0 +1,73 @@
+#include "eval-profiler.hh"
+#include "file-system.hh"
+#include "logging.hh"
+
+namespace nix {
+
+EvalProfiler::EvalProfiler(EvalState & state, const Path & profileFile, unsigned int frequency)
+    : state(state)
+    , profileFile(profileFile)
+{
+    if (frequency == 0)
+        throw UsageError("'eval-profiler-frequency' must be greater than zero");
+
+    auto interval = std::chrono::nanoseconds(1'000'000'000 / frequency);
+
+    timer = std::thread([this, interval]() {
+        std::unique_lock lock(quitMutex);
+        while (!quitCV.wait_for(lock, interval, [&]() { return quit; }))
+            sampleRequested.store(true, std::memory_order_relaxed);
+    });
+}
+
+EvalProfiler::~EvalProfiler()
+{
+    {
+        std::lock_guard lock(quitMutex);
+        quit = true;
+    }
+    quitCV.notify_one();
+    timer.join();
+
+    try {
+        write();
+    } catch (...) {
+        ignoreExceptionExceptInterrupt();
+    }
+}
+
+std::string EvalProfiler::showFrame(const Frame & frame)
+{
+    if (frame.primOp)
+        return frame.primOp->name;
+
+    auto & lambda = *frame.lambda;
+    std::ostringstream str;
+    state.positions[lambda.pos].print(str, true);
+    str << ":" << (lambda.name ? std::string_view(state.symbols[lambda.name]) : "anonymous lambda");
+    /* Semicolons separate the frames in the output. */
+    return replaceStrings(str.str(), ";", "_");
+}
+
+void EvalProfiler::write()
+{
+    std::map<Frame, std::string> names;
+    std::string out;
+
+    for (auto & [stack, count] : samples) {
+        if (stack.empty()) continue;
+        for (auto & frame : stack) {
+            auto i = names.find(frame);
+            if (i == names.end())
+                i = names.emplace(frame, showFrame(frame)).first;
+            if (&frame != &stack.front()) out += ';';
+            out += i->second;
+        }
+        out += fmt(" %d\n", count);
+    }
+
+    writeFile(profileFile, out);
+    printTalkative("wrote evaluation profile to '%s'", profileFile);
+}
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+///@file
+
+#include "eval.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+namespace nix {
+
+/**
+ * A sampling profiler for Nix expressions. The evaluator reports
+ * every call of a lambda or primop to it. At a fixed frequency, a
+ * background thread asks for the current Nix call stack to be
+ * recorded. When the profiler is destroyed, it writes the number of
+ * times each stack was seen to a file in the "collapsed stacks"
+ * format used by flame graph tools, e.g.
+ *
+ *     /foo/default.nix:1:2:anonymous lambda;/foo/default.nix:3:7:f;map 12
+ */
+class EvalProfiler
+{
+public:
+    /**
+     * A function on the Nix call stack: either a lambda or a primop.
+     */
+    struct Frame
+    {
+        const ExprLambda * lambda = nullptr;
+        const PrimOp * primOp = nullptr;
+
+        auto operator <=>(const Frame &) const = default;
+    };
+
+    /**
+     * Registers a call for as long as it is alive.
+     */
+    struct Call
+    {
+        EvalProfiler * profiler;
+
+        Call(EvalProfiler * profiler, Frame frame)
+            : profiler(profiler)
+        {
+            if (profiler) [[unlikely]] profiler->enter(frame);
+        }
+
+        ~Call()
+        {
+            if (profiler) [[unlikely]] profiler->leave();
+        }
+    };
+
+    EvalProfiler(EvalState & state, const Path & profileFile, unsigned int frequency);
+
+    ~EvalProfiler();
+
+    void enter(Frame frame)
+    {
+        stack.push_back(frame);
+        maybeSample();
+    }
+
+    void leave()
+    {
+        maybeSample();
+        stack.pop_back();
+    }
+
+    /**
+     * Write the samples taken so far to the profile file.
+     */
+    void write();
+
+private:
+    EvalState & state;
+    Path profileFile;
+
+    std::vector<Frame> stack;
+
+    std::map<std::vector<Frame>, uint64_t> samples;
+
+    /**
+     * Set by the timer thread when the next call or return should
+     * record the stack.
+     */
+    std::atomic<bool> sampleRequested = false;
+
+    bool quit = false;
+    std::mutex quitMutex;
+    std::condition_variable quitCV;
+    std::thread timer;
+
+    void maybeSample()
+    {
+        if (sampleRequested.load(std::memory_order_relaxed)) [[unlikely]] {
+            sampleRequested.store(false, std::memory_order_relaxed);
+            samples[stack]++;
+        }
+    }
+
+    std::string showFrame(const Frame & frame);
+};
+
+}
@@ -2,6 +2,7 @@
 ///@file
 
 #include "config.hh"
+#include "eval-profiler-settings.hh"
 #include "ref.hh"
 #include "source-path.hh"
 
@@ -191,6 +192,37 @@ struct EvalSettings : Config
           `flamegraph.pl`.
         )"};
 
+    Setting<EvalProfilerMode> evalProfilerMode{this, EvalProfilerMode::disabled, "eval-profiler",
+        R"(
+          Enables evaluation profiling. The following modes are supported:
+
+          - `disabled`: Don't profile the evaluation.
+
+          - `flamegraph`: Periodically record the Nix call stack (the
+            lambdas and built-in functions being called) and, when
+            evaluation finishes, write the number of times each stack
+            was seen to [`eval-profile-file`](#conf-eval-profile-file).
+            The result uses the "collapsed stacks" format that flame
+            graph tools like `flamegraph.pl` and
+            [speedscope](https://www.speedscope.app/) accept.
+
+          Unlike [`trace-function-calls`](#conf-trace-function-calls),
+          this has little overhead and is suitable for profiling large
+          evaluations.
+        )"};
+
+    Setting<Path> evalProfileFile{this, "nix.profile", "eval-profile-file",
+        R"(
+          The file to which the evaluation profile is written when
+          [`eval-profiler`](#conf-eval-profiler) is enabled.
+        )"};
+
+    Setting<unsigned int> evalProfilerFrequency{this, 99, "eval-profiler-frequency",
+        R"(
+          The number of times per second that the evaluation profiler
+          records the Nix call stack.
+        )"};
+
     Setting<bool> useEvalCache{this, true, "eval-cache",
         R"(
             Whether to use the flake evaluation cache.
@@ -198,6 +230,27 @@ struct EvalSettings : Config
             Intermediate results are not cached.
         )"};
 
+    Setting<bool> parseCache{this, false, "parse-cache",
+        R"(
+          Whether to keep the parse trees of Nix files in an on-disk cache.
+
+          Entries are stored in `~/.cache/nix/parse-cache-v1`, keyed by
+          the hash of the file contents, and are loaded instead of lexing
+          and parsing a file again in a later Nix invocation. The least
+          recently used entries are deleted when the cache grows beyond
+          [`parse-cache-max-size`](#conf-parse-cache-max-size).
+
+          An entry is read in full and decoded into a new parse tree, so
+          a cache hit still costs time proportional to the size of the
+          file, but saves the lexer and parser.
+        )"};
+
+    Setting<uint64_t> parseCacheMaxSize{this, 256 * 1024 * 1024, "parse-cache-max-size",
+        R"(
+          The maximum size in bytes of the parse cache enabled by
+          [`parse-cache`](#conf-parse-cache).
+        )"};
+
     Setting<bool> ignoreExceptionsDuringTry{this, false, "ignore-try",
         R"(
           If set to true, ignore exceptions inside 'tryEval' calls when evaluating nix expressions in
@@ -11,6 +11,8 @@
 #include "eval-inline.hh"
 #include "filetransfer.hh"
 #include "function-trace.hh"
+#include "eval-profiler.hh"
+#include "finally.hh"
 #include "profiles.hh"
 #include "print.hh"
 #include "filtering-source-accessor.hh"
@@ -20,6 +22,7 @@
 #include "fetch-to-store.hh"
 #include "tarball.hh"
 #include "parser-tab.hh"
+#include "parse-cache.hh"
 
 #include <algorithm>
 #include <iostream>
@@ -95,7 +98,7 @@ void Value::print(EvalState & state, std::ostream & str, PrintOptions options)
 const Value * getPrimOp(const Value &v) {
     const Value * primOp = &v;
     while (primOp->isPrimOpApp()) {
-        primOp = primOp->payload.primOpApp.left;
+        primOp = primOp->primOpApp().left;
     }
     assert(primOp->isPrimOp());
     return primOp;
@@ -126,12 +129,12 @@ std::string showType(const Value & v)
     // Allow selecting a subset of enum values
     #pragma GCC diagnostic push
     #pragma GCC diagnostic ignored "-Wswitch-enum"
-    switch (v.internalType) {
-        case tString: return v.payload.string.context ? "a string with context" : "a string";
+    switch (v.internalType()) {
+        case tString: return v.context() ? "a string with context" : "a string";
         case tPrimOp:
-            return fmt("the built-in function '%s'", std::string(v.payload.primOp->name));
+            return fmt("the built-in function '%s'", std::string(v.primOp()->name));
         case tPrimOpApp:
-            return fmt("the partially applied built-in function '%s'", std::string(getPrimOp(v)->payload.primOp->name));
+            return fmt("the partially applied built-in function '%s'", std::string(getPrimOp(v)->primOp()->name));
         case tExternal: return v.external()->showType();
         case tThunk: return v.isBlackhole() ? "a black hole" : "a thunk";
         case tApp: return "a function application";
@@ -146,10 +149,10 @@ PosIdx Value::determinePos(const PosIdx pos) const
     // Allow selecting a subset of enum values
     #pragma GCC diagnostic push
     #pragma GCC diagnostic ignored "-Wswitch-enum"
-    switch (internalType) {
+    switch (internalType()) {
         case tAttrs: return attrs()->pos;
-        case tLambda: return payload.lambda.fun->pos;
-        case tApp: return payload.app.left->determinePos(pos);
+        case tLambda: return lambda().fun->pos;
+        case tApp: return app().left->determinePos(pos);
         default: return pos;
     }
     #pragma GCC diagnostic pop
@@ -158,13 +161,13 @@ PosIdx Value::determinePos(const PosIdx pos) const
 bool Value::isTrivial() const
 {
     return
-        internalType != tApp
-        && internalType != tPrimOpApp
-        && (internalType != tThunk
-            || (dynamic_cast<ExprAttrs *>(payload.thunk.expr)
-                && ((ExprAttrs *) payload.thunk.expr)->dynamicAttrs.empty())
-            || dynamic_cast<ExprLambda *>(payload.thunk.expr)
-            || dynamic_cast<ExprList *>(payload.thunk.expr));
+        !isApp()
+        && !isPrimOpApp()
+        && (!isThunk()
+            || (dynamic_cast<ExprAttrs *>(thunk().expr)
+                && ((ExprAttrs *) thunk().expr)->dynamicAttrs.empty())
+            || dynamic_cast<ExprLambda *>(thunk().expr)
+            || dynamic_cast<ExprList *>(thunk().expr));
 }
 
 
@@ -285,6 +288,11 @@ EvalState::EvalState(
     internalFS->setPathDisplay("«nix-internal»", "");
 
     countCalls = getEnv("NIX_COUNT_CALLS").value_or("0") != "0";
+    countAllocs = getEnv("NIX_COUNT_ALLOCS").value_or("0") != "0";
+    curAllocationSite = &allocationSites[noPos];
+
+    if (settings.evalProfilerMode == EvalProfilerMode::flamegraph)
+        profiler = std::make_unique<EvalProfiler>(*this, settings.evalProfileFile, settings.evalProfilerFrequency);
 
     assertGCInitialized();
 
@@ -448,7 +456,7 @@ void EvalState::addConstant(const std::string & name, Value * v, Constant info)
         /* Install value the base environment. */
         staticBaseEnv->vars.emplace_back(symbols.create(name), baseEnvDispl);
         baseEnv.values[baseEnvDispl++] = v;
-        getBuiltins().payload.attrs->push_back(Attr(symbols.create(name2), v));
+        const_cast<Bindings *>(getBuiltins().attrs())->push_back(Attr(symbols.create(name2), v));
     }
 }
 
@@ -470,9 +478,9 @@ std::ostream & operator<<(std::ostream & output, const PrimOp & primOp)
 
 const PrimOp * Value::primOpAppPrimOp() const
 {
-    Value * left = payload.primOpApp.left;
+    Value * left = primOpApp().left;
     while (left && !left->isPrimOp()) {
-        left = left->payload.primOpApp.left;
+        left = left->primOpApp().left;
     }
 
     if (!left)
@@ -484,7 +492,8 @@ const PrimOp * Value::primOpAppPrimOp() const
 void Value::mkPrimOp(PrimOp * p)
 {
     p->check();
-    finishValue(tPrimOp, { .primOp = p });
+    setSingleWord(tPrimOp);
+    word1.primOp = p;
 }
 
 
@@ -516,7 +525,7 @@ Value * EvalState::addPrimOp(PrimOp && primOp)
     else {
         staticBaseEnv->vars.emplace_back(envName, baseEnvDispl);
         baseEnv.values[baseEnvDispl++] = v;
-        getBuiltins().payload.attrs->push_back(Attr(symbols.create(primOp.name), v));
+        const_cast<Bindings *>(getBuiltins().attrs())->push_back(Attr(symbols.create(primOp.name), v));
     }
 
     return v;
@@ -553,7 +562,7 @@ std::optional<EvalState::Doc> EvalState::getDoc(Value & v)
             };
     }
     if (v.isLambda()) {
-        auto exprLambda = v.payload.lambda.fun;
+        auto exprLambda = v.lambda().fun;
 
         std::ostringstream s;
         std::string name;
@@ -597,7 +606,7 @@ std::optional<EvalState::Doc> EvalState::getDoc(Value & v)
     }
     if (isFunctor(v)) {
         try {
-            Value & functor = *v.attrs()->find(sFunctor)->value;
+            Value & functor = *v.attrs()->get(sFunctor)->value;
             Value * vp[] = {&v};
             Value partiallyApplied;
             // The first paramater is not user-provided, and may be
@@ -886,9 +895,42 @@ inline Value * EvalState::lookupVar(Env * env, const ExprVar & var, bool noEval)
 
 ListBuilder::ListBuilder(EvalState & state, size_t size)
     : size(size)
-    , elems(size <= 2 ? inlineElems : (Value * *) allocBytes(size * sizeof(Value *)))
+    , elems(size <= 1 ? inlineElems : (Value * *) allocBytes(size * sizeof(Value *)))
 {
     state.nrListElems += size;
+    if (state.countAllocs && size > 1) [[unlikely]]
+        state.countAllocation(size * sizeof(Value *));
+}
+
+void Value::flattenList() const
+{
+    assert(internalType() == tListConcat);
+
+    auto size = word1.listConcat->size;
+    auto elems = (Value * *) allocBytes(size * sizeof(Value *));
+
+    /* Walk the tree of parts without recursion, as a list built by
+       appending to it in a loop is a very deep tree. */
+    std::vector<const Value *> todo{this};
+    size_t pos = 0;
+    while (!todo.empty()) {
+        auto list = todo.back();
+        todo.pop_back();
+        if (list->internalType() == tListConcat) {
+            auto concat = list->word1.listConcat;
+            for (size_t n = concat->nrLists; n > 0; --n)
+                todo.push_back(&concat->lists[n - 1]);
+        } else {
+            auto l = list->listSize();
+            memcpy(elems + pos, list->listElems(), l * sizeof(Value *));
+            pos += l;
+        }
+    }
+    assert(pos == size);
+
+    /* This doesn't change the value, only its representation, so
+       it's fine to do on a const value. */
+    const_cast<Value *>(this)->setTwoWords(pdListN, elems, size);
 }
 
 Value * EvalState::getBool(bool b) {
@@ -1360,6 +1402,20 @@ static std::string showAttrPath(EvalState & state, Env & env, const AttrPath & a
 }
 
 
+inline const Attr * EvalState::getAttrCached(const Bindings & attrs, Symbol name, const AttrName & attrName)
+{
+    if (auto j = attrs.getAt(attrName.cacheIndex, name)) {
+        nrAttrCacheHits++;
+        return j;
+    }
+    nrAttrCacheMisses++;
+    auto j = attrs.get(name);
+    if (j && attrs.numLayers() == 1)
+        attrName.cacheIndex = j - &attrs[0];
+    return j;
+}
+
+
 void ExprSelect::eval(EvalState & state, Env & env, Value & v)
 {
     Value vTmp;
@@ -1386,14 +1442,14 @@ void ExprSelect::eval(EvalState & state, Env & env, Value & v)
             if (def) {
                 state.forceValue(*vAttrs, pos);
                 if (vAttrs->type() != nAttrs ||
-                    !(j = vAttrs->attrs()->get(name)))
+                    !(j = state.getAttrCached(*vAttrs->attrs(), name, i)))
                 {
                     def->eval(state, env, v);
                     return;
                 }
             } else {
                 state.forceAttrs(*vAttrs, pos, "while selecting an attribute");
-                if (!(j = vAttrs->attrs()->get(name))) {
+                if (!(j = state.getAttrCached(*vAttrs->attrs(), name, i))) {
                     std::set<std::string> allAttrNames;
                     for (auto & attr : *vAttrs->attrs())
                         allAttrNames.insert(std::string(state.symbols[attr.name]));
@@ -1452,7 +1508,7 @@ void ExprOpHasAttr::eval(EvalState & state, Env & env, Value & v)
         const Attr * j;
         auto name = getName(i, state, env);
         if (vAttrs->type() == nAttrs &&
-            (j = vAttrs->attrs()->get(name)))
+            (j = state.getAttrCached(*vAttrs->attrs(), name, i)))
         {
             vAttrs = j->value;
         } else {
@@ -1498,13 +1554,19 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
 
         if (vCur.isLambda()) {
 
-            ExprLambda & lambda(*vCur.payload.lambda.fun);
+            ExprLambda & lambda(*vCur.lambda().fun);
+
+            /* Attribute the allocations made by this call to the
+               lambda. */
+            auto prevAllocationSite = curAllocationSite;
+            if (countAllocs) [[unlikely]] curAllocationSite = &allocationSites[lambda.pos];
+            Finally restoreAllocationSite([&]() { curAllocationSite = prevAllocationSite; });
 
             auto size =
                 (!lambda.arg ? 0 : 1) +
                 (lambda.hasFormals() ? lambda.formals->formals.size() : 0);
             Env & env2(allocEnv(size));
-            env2.up = vCur.payload.lambda.env;
+            env2.up = vCur.lambda().env;
 
             Displacement displ = 0;
 
@@ -1534,7 +1596,7 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
                                              symbols[i.name])
                                     .atPos(lambda.pos)
                                     .withTrace(pos, "from call site")
-                                    .withFrame(*fun.payload.lambda.env, lambda)
+                                    .withFrame(*fun.lambda().env, lambda)
                                     .debugThrow();
                         }
                         env2.values[displ++] = i.def->maybeThunk(*this, env2);
@@ -1561,7 +1623,7 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
                                 .atPos(lambda.pos)
                                 .withTrace(pos, "from call site")
                                 .withSuggestions(suggestions)
-                                .withFrame(*fun.payload.lambda.env, lambda)
+                                .withFrame(*fun.lambda().env, lambda)
                                 .debugThrow();
                         }
                     unreachable();
@@ -1582,6 +1644,8 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
                         : "anonymous lambda")
                     : nullptr;
 
+                EvalProfiler::Call _call(profiler.get(), {.lambda = &lambda});
+
                 lambda.body->eval(*this, env2, vCur);
             } catch (Error & e) {
                 if (loggerSettings.showTrace.get()) {
@@ -1616,6 +1680,7 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
                 if (countCalls) primOpCalls[fn->name]++;
 
                 try {
+                    EvalProfiler::Call _call(profiler.get(), {.primOp = fn});
                     fn->fun(*this, vCur.determinePos(noPos), args.data(), vCur);
                 } catch (Error & e) {
                     if (fn->addTrace)
@@ -1633,7 +1698,7 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
             Value * primOp = &vCur;
             while (primOp->isPrimOpApp()) {
                 argsDone++;
-                primOp = primOp->payload.primOpApp.left;
+                primOp = primOp->primOpApp().left;
             }
             assert(primOp->isPrimOp());
             auto arity = primOp->primOp()->arity;
@@ -1649,8 +1714,8 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
 
                 Value * vArgs[maxPrimOpArity];
                 auto n = argsDone;
-                for (Value * arg = &vCur; arg->isPrimOpApp(); arg = arg->payload.primOpApp.left)
-                    vArgs[--n] = arg->payload.primOpApp.right;
+                for (Value * arg = &vCur; arg->isPrimOpApp(); arg = arg->primOpApp().left)
+                    vArgs[--n] = arg->primOpApp().right;
 
                 for (size_t i = 0; i < argsLeft; ++i)
                     vArgs[argsDone + i] = args[i];
@@ -1664,6 +1729,7 @@ void EvalState::callFunction(Value & fun, std::span<Value *> args, Value & vRes,
                     // 1. Unify this and above code. Heavily redundant.
                     // 2. Create a fake env (arg1, arg2, etc.) and a fake expr (arg1: arg2: etc: builtins.name arg1 arg2 etc)
                     //    so the debugger allows to inspect the wrong parameters passed to the builtin.
+                    EvalProfiler::Call _call(profiler.get(), {.primOp = fn});
                     fn->fun(*this, vCur.determinePos(noPos), vArgs, vCur);
                 } catch (Error & e) {
                     if (fn->addTrace)
@@ -1749,8 +1815,8 @@ void EvalState::autoCallFunction(const Bindings & args, Value & fun, Value & res
     forceValue(fun, pos);
 
     if (fun.type() == nAttrs) {
-        auto found = fun.attrs()->find(sFunctor);
-        if (found != fun.attrs()->end()) {
+        auto found = fun.attrs()->get(sFunctor);
+        if (found) {
             Value * v = allocValue();
             callFunction(*found->value, fun, *v, pos);
             forceValue(*v, pos);
@@ -1758,14 +1824,14 @@ void EvalState::autoCallFunction(const Bindings & args, Value & fun, Value & res
         }
     }
 
-    if (!fun.isLambda() || !fun.payload.lambda.fun->hasFormals()) {
+    if (!fun.isLambda() || !fun.lambda().fun->hasFormals()) {
         res = fun;
         return;
     }
 
-    auto attrs = buildBindings(std::max(static_cast<uint32_t>(fun.payload.lambda.fun->formals->formals.size()), args.size()));
+    auto attrs = buildBindings(std::max(static_cast<uint32_t>(fun.lambda().fun->formals->formals.size()), args.size()));
 
-    if (fun.payload.lambda.fun->formals->ellipsis) {
+    if (fun.lambda().fun->formals->ellipsis) {
         // If the formals have an ellipsis (eg the function accepts extra args) pass
         // all available automatic arguments (which includes arguments specified on
         // the command line via --arg/--argstr)
@@ -1773,7 +1839,7 @@ void EvalState::autoCallFunction(const Bindings & args, Value & fun, Value & res
             attrs.insert(v);
     } else {
         // Otherwise, only pass the arguments that the function accepts
-        for (auto & i : fun.payload.lambda.fun->formals->formals) {
+        for (auto & i : fun.lambda().fun->formals->formals) {
             auto j = args.get(i.name);
             if (j) {
                 attrs.insert(*j);
@@ -1783,7 +1849,7 @@ Nix attempted to evaluate a function as a top level expression; in
 this case it must have its arguments supplied either by default
 values, or passed explicitly with '--arg' or '--argstr'. See
 https://nixos.org/manual/nix/stable/language/constructs.html#functions.)", symbols[i.name])
-                    .atPos(i.pos).withFrame(*fun.payload.lambda.env, *fun.payload.lambda.fun).debugThrow();
+                    .atPos(i.pos).withFrame(*fun.lambda().env, *fun.lambda().fun).debugThrow();
             }
         }
     }
@@ -1884,6 +1950,23 @@ void ExprOpUpdate::eval(EvalState & state, Env & env, Value & v)
     if (v1.attrs()->size() == 0) { v = v2; return; }
     if (v2.attrs()->size() == 0) { v = v1; return; }
 
+    /* If the second set is small compared to the first, don't copy
+       the first set but put the attributes of the second set in a
+       layer on top of it. */
+    if (v2.attrs()->size() * 4 <= v1.attrs()->size()
+        && v1.attrs()->numLayers() < Bindings::maxLayers)
+    {
+        auto layer = state.allocBindings(v2.attrs()->size(), true);
+        for (auto & a : *v2.attrs())
+            layer->push_back(a);
+        layer->setBaseLayer(*v1.attrs());
+        v.mkAttrs(layer);
+
+        state.nrOpUpdatesLayered++;
+        state.nrOpUpdateValuesCopied += layer->capacity();
+        return;
+    }
+
     auto attrs = state.buildBindings(v1.attrs()->size() + v2.attrs()->size());
 
     /* Merge the sets, preferring values from the second set.  Make
@@ -1938,6 +2021,27 @@ void EvalState::concatLists(Value & v, size_t nrLists, Value * const * lists, co
         return;
     }
 
+    /* If the lists aren't tiny, don't copy their elements but
+       remember the lists, so that appending to a list in a loop
+       doesn't take quadratic time. The elements are copied when
+       they're first needed. */
+    size_t nrNonEmpty = 0;
+    for (size_t n = 0; n < nrLists; ++n)
+        if (lists[n]->listSize()) nrNonEmpty++;
+
+    if (len >= 32 && nrNonEmpty * 8 <= len) {
+        auto concat = (ListConcat *) allocBytes(sizeof(ListConcat) + nrNonEmpty * sizeof(Value));
+        if (countAllocs) [[unlikely]]
+            countAllocation(sizeof(ListConcat) + nrNonEmpty * sizeof(Value));
+        concat->size = len;
+        for (size_t n = 0; n < nrLists; ++n)
+            if (lists[n]->listSize())
+                concat->lists[concat->nrLists++] = *lists[n];
+        v.mkListConcat(concat);
+        nrListConcatsLazy++;
+        return;
+    }
+
     auto list = buildList(len);
     auto out = list.elems;
     for (size_t n = 0, pos = 0; n < nrLists; ++n) {
@@ -2096,7 +2200,7 @@ void EvalState::forceValueDeep(Value & v)
                 try {
                     // If the value is a thunk, we're evaling. Otherwise no trace necessary.
                     auto dts = debugRepl && i.value->isThunk()
-                        ? makeDebugTraceStacker(*this, *i.value->payload.thunk.expr, *i.value->payload.thunk.env, positions[i.pos],
+                        ? makeDebugTraceStacker(*this, *i.value->thunk().expr, *i.value->thunk().env, positions[i.pos],
                             "while evaluating the attribute '%1%'", symbols[i.name])
                         : nullptr;
 
@@ -2179,7 +2283,7 @@ bool EvalState::forceBool(Value & v, const PosIdx pos, std::string_view errorCtx
 
 bool EvalState::isFunctor(Value & fun)
 {
-    return fun.type() == nAttrs && fun.attrs()->find(sFunctor) != fun.attrs()->end();
+    return fun.type() == nAttrs && fun.attrs()->get(sFunctor);
 }
 
 
@@ -2220,8 +2324,8 @@ std::string_view EvalState::forceString(Value & v, const PosIdx pos, std::string
 
 void copyContext(const Value & v, NixStringContext & context)
 {
-    if (v.payload.string.context)
-        for (const char * * p = v.payload.string.context; *p; ++p)
+    if (v.context())
+        for (const char * * p = v.context(); *p; ++p)
             context.insert(NixStringContextElem::parse(*p));
 }
 
@@ -2258,8 +2362,8 @@ bool EvalState::isDerivation(Value & v)
 std::optional<std::string> EvalState::tryAttrsToString(const PosIdx pos, Value & v,
     NixStringContext & context, bool coerceMore, bool copyToStore)
 {
-    auto i = v.attrs()->find(sToString);
-    if (i != v.attrs()->end()) {
+    auto i = v.attrs()->get(sToString);
+    if (i) {
         Value v1;
         callFunction(*i->value, v, v1, pos);
         return coerceToString(pos, v1, context,
@@ -2291,7 +2395,7 @@ BackedStringView EvalState::coerceToString(
             !canonicalizePath && !copyToStore
             ? // FIXME: hack to preserve path literals that end in a
               // slash, as in /foo/${x}.
-              v.payload.path.path
+              v.pathStr()
             : copyToStore
             ? store->printStorePath(copyPathToStore(context, v.path()))
             : std::string(v.path().path.abs());
@@ -2301,8 +2405,8 @@ BackedStringView EvalState::coerceToString(
         auto maybeString = tryAttrsToString(pos, v, context, coerceMore, copyToStore);
         if (maybeString)
             return std::move(*maybeString);
-        auto i = v.attrs()->find(sOutPath);
-        if (i == v.attrs()->end()) {
+        auto i = v.attrs()->get(sOutPath);
+        if (!i) {
             error<TypeError>(
                 "cannot coerce %1% to a string: %2%",
                 showType(v),
@@ -2409,8 +2513,8 @@ SourcePath EvalState::coerceToPath(const PosIdx pos, Value & v, NixStringContext
     /* Similarly, handle __toString where the result may be a path
        value. */
     if (v.type() == nAttrs) {
-        auto i = v.attrs()->find(sToString);
-        if (i != v.attrs()->end()) {
+        auto i = v.attrs()->get(sToString);
+        if (i) {
             Value v1;
             callFunction(*i->value, v, v1, pos);
             return coerceToPath(pos, v1, context, errorCtx);
@@ -2558,14 +2662,14 @@ void EvalState::assertEqValues(Value & v1, Value & v2, const PosIdx pos, std::st
         return;
 
     case nPath:
-        if (v1.payload.path.accessor != v2.payload.path.accessor) {
+        if (v1.pathAccessor() != v2.pathAccessor()) {
             error<AssertionError>(
                 "path '%s' is not equal to path '%s' because their accessors are different",
                 ValuePrinter(*this, v1, errorPrintOptions),
                 ValuePrinter(*this, v2, errorPrintOptions))
                 .debugThrow();
         }
-        if (strcmp(v1.payload.path.path, v2.payload.path.path) != 0) {
+        if (strcmp(v1.pathStr(), v2.pathStr()) != 0) {
             error<AssertionError>(
                 "path '%s' is not equal to path '%s'",
                 ValuePrinter(*this, v1, errorPrintOptions),
@@ -2732,8 +2836,8 @@ bool EvalState::eqValues(Value & v1, Value & v2, const PosIdx pos, std::string_v
         case nPath:
             return
                 // FIXME: compare accessors by their fingerprint.
-                v1.payload.path.accessor == v2.payload.path.accessor
-                && strcmp(v1.payload.path.path, v2.payload.path.path) == 0;
+                v1.pathAccessor() == v2.pathAccessor()
+                && strcmp(v1.pathStr(), v2.pathStr()) == 0;
 
         case nNull:
             return true;
@@ -2864,6 +2968,7 @@ void EvalState::printStatistics()
         {"elements", nrListElems},
         {"bytes", bLists},
         {"concats", nrListConcats},
+        {"lazyConcats", nrListConcatsLazy},
     };
     topObj["values"] = {
         {"number", nrValues},
@@ -2886,9 +2991,12 @@ void EvalState::printStatistics()
     };
     topObj["nrOpUpdates"] = nrOpUpdates;
     topObj["nrOpUpdateValuesCopied"] = nrOpUpdateValuesCopied;
+    topObj["nrOpUpdatesLayered"] = nrOpUpdatesLayered;
     topObj["nrThunks"] = nrThunks;
     topObj["nrAvoided"] = nrAvoided;
     topObj["nrLookups"] = nrLookups;
+    topObj["nrAttrCacheHits"] = nrAttrCacheHits;
+    topObj["nrAttrCacheMisses"] = nrAttrCacheMisses;
     topObj["nrPrimOpCalls"] = nrPrimOpCalls;
     topObj["nrFunctionCalls"] = nrFunctionCalls;
 #if HAVE_BOEHMGC
@@ -2937,6 +3045,30 @@ void EvalState::printStatistics()
         }
     }
 
+    if (countAllocs) {
+        /* Only show the sites that allocated the most bytes. */
+        const size_t maxSites = 100;
+        std::vector<std::pair<PosIdx, AllocationStats>> sites(allocationSites.begin(), allocationSites.end());
+        auto end = sites.begin() + std::min(sites.size(), maxSites);
+        std::partial_sort(sites.begin(), end, sites.end(), [](auto & a, auto & b) {
+            return a.second.bytes > b.second.bytes;
+        });
+        auto & list = topObj["allocations"];
+        list = json::array();
+        for (auto i = sites.begin(); i != end; ++i) {
+            json obj = json::object();
+            if (auto pos = positions[i->first]) {
+                if (auto path = std::get_if<SourcePath>(&pos.origin))
+                    obj["file"] = path->to_string();
+                obj["line"] = pos.line;
+                obj["column"] = pos.column;
+            }
+            obj["count"] = i->second.count;
+            obj["bytes"] = i->second.bytes;
+            list.push_back(obj);
+        }
+    }
+
     if (getEnv("NIX_SHOW_SYMBOLS").value_or("0") != "0") {
         // XXX: overrides earlier assignment
         topObj["symbols"] = json::array();
@@ -3131,12 +3263,43 @@ Expr * EvalState::parse(
     DocCommentMap tmpDocComments; // Only used when not origin is not a SourcePath
     DocCommentMap *docComments = &tmpDocComments;
 
-    if (auto sourcePath = std::get_if<SourcePath>(&origin)) {
+    auto sourcePath = std::get_if<SourcePath>(&origin);
+    if (sourcePath) {
         auto [it, _] = positionToDocComment.try_emplace(*sourcePath);
         docComments = &it->second;
     }
 
-    auto result = parseExprFromBuf(text, length, origin, basePath, symbols, settings, positions, *docComments, rootFS, exprSymbols);
+    auto posOrigin = positions.addOrigin(origin, length);
+
+    Expr * result = nullptr;
+
+    std::optional<Path> cachePath;
+    if (sourcePath && settings.parseCache)
+        cachePath = getParseCachePath(*sourcePath, {text, length}, settings);
+
+    if (cachePath) {
+        try {
+            if (auto data = readParseCacheEntry(*cachePath))
+                result = deserialiseParsedExpr(*data, symbols, positions, posOrigin, *docComments, rootFS);
+        } catch (Error & e) {
+            debug("ignoring parse cache entry '%s': %s", *cachePath, e.msg());
+        }
+    }
+
+    if (!result) {
+        result = parseExprFromBuf(text, length, posOrigin, basePath, symbols, settings, positions, *docComments, rootFS, exprSymbols);
+
+        if (cachePath) {
+            try {
+                writeParseCacheEntry(
+                    *cachePath,
+                    serialiseParsedExpr(result, symbols, posOrigin, *docComments),
+                    settings.parseCacheMaxSize);
+            } catch (std::exception & e) {
+                debug("cannot write parse cache entry '%s': %s", *cachePath, e.what());
+            }
+        }
+    }
 
     result->bindVars(*this, staticEnv);
 
@@ -33,6 +33,7 @@ class Store;
 namespace fetchers { struct Settings; }
 struct EvalSettings;
 class EvalState;
+class EvalProfiler;
 class StorePath;
 struct SingleDerivedPath;
 enum RepairFlag : bool;
@@ -277,6 +278,42 @@ public:
 
     RootValue vImportedDrvToDerivation = nullptr;
 
+    /**
+     * The evaluation profiler, if `eval-profiler` is enabled.
+     */
+    std::unique_ptr<EvalProfiler> profiler;
+
+    /**
+     * Whether to count allocations per lambda. This is declared
+     * before `baseEnv` because allocating that needs it.
+     */
+    bool countAllocs = false;
+
+    struct AllocationStats
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    /**
+     * Allocations per lambda, if `NIX_COUNT_ALLOCS` is set.
+     * Allocations made outside of any lambda are counted under
+     * `noPos`.
+     */
+    std::unordered_map<PosIdx, AllocationStats> allocationSites;
+
+    /**
+     * The entry in `allocationSites` of the lambda that is currently
+     * being called.
+     */
+    AllocationStats * curAllocationSite = nullptr;
+
+    void countAllocation(size_t bytes)
+    {
+        curAllocationSite->count++;
+        curAllocationSite->bytes += bytes;
+    }
+
     /**
      * Debugger
      */
@@ -661,6 +698,14 @@ private:
 
     inline Value * lookupVar(Env * env, const ExprVar & var, bool noEval);
 
+    /**
+     * Look up `name` in `attrs`, first trying the index at which
+     * `attrName` was found the last time. That is usually correct
+     * when an expression is evaluated repeatedly on sets of the same
+     * shape.
+     */
+    const Attr * getAttrCached(const Bindings & attrs, Symbol name, const AttrName & attrName);
+
     friend struct ExprVar;
     friend struct ExprAttrs;
     friend struct ExprLet;
@@ -721,7 +766,12 @@ public:
     inline Value * allocValue();
     inline Env & allocEnv(size_t size);
 
-    Bindings * allocBindings(size_t capacity);
+    /**
+     * Allocate a set with room for `capacity` attributes. A set that
+     * will be put on top of another with `Bindings::setBaseLayer()`
+     * must be `layered`.
+     */
+    Bindings * allocBindings(size_t capacity, bool layered = false);
 
     BindingsBuilder buildBindings(size_t capacity)
     {
@@ -846,12 +896,16 @@ private:
     unsigned long nrValues = 0;
     unsigned long nrListElems = 0;
     unsigned long nrLookups = 0;
+    unsigned long nrAttrCacheHits = 0;
+    unsigned long nrAttrCacheMisses = 0;
     unsigned long nrAttrsets = 0;
     unsigned long nrAttrsInAttrsets = 0;
     unsigned long nrAvoided = 0;
     unsigned long nrOpUpdates = 0;
     unsigned long nrOpUpdateValuesCopied = 0;
+    unsigned long nrOpUpdatesLayered = 0;
     unsigned long nrListConcats = 0;
+    unsigned long nrListConcatsLazy = 0;
     unsigned long nrPrimOpCalls = 0;
     unsigned long nrFunctionCalls = 0;
 
@@ -876,6 +930,7 @@ private:
     friend struct ExprFloat;
     friend struct ExprPath;
     friend struct ExprSelect;
+    friend struct ExprOpHasAttr;
     friend void prim_getAttr(EvalState & state, const PosIdx pos, Value * * args, Value & v);
     friend void prim_match(EvalState & state, const PosIdx pos, Value * * args, Value & v);
     friend void prim_split(EvalState & state, const PosIdx pos, Value * * args, Value & v);
@@ -65,6 +65,11 @@ struct DocComment {
 struct AttrName
 {
     Symbol symbol;
+    /**
+     * Inline cache for attribute selection: the index in the
+     * attribute set at which this attribute was last found.
+     */
+    mutable uint32_t cacheIndex = 0;
     Expr * expr;
     AttrName(Symbol s) : symbol(s) {};
     AttrName(Expr * e) : expr(e) {};
@@ -0,0 +1,851 @@
+#include "parse-cache.hh"
+#include "eval-settings.hh"
+#include "globals.hh"
+#include "users.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace nix {
+
+/**
+ * Bump this whenever the encoding below changes.
+ */
+static constexpr uint64_t parseCacheVersion = 1;
+
+static constexpr std::string_view parseCacheMagic = "nix-parse-cache\n";
+
+/**
+ * One tag byte precedes every serialised expression node.
+ */
+enum class ExprTag : uint8_t
+{
+    Null,
+    BackRef,
+    Int,
+    Float,
+    String,
+    Path,
+    Var,
+    InheritFrom,
+    Select,
+    OpHasAttr,
+    Attrs,
+    List,
+    Lambda,
+    Call,
+    Let,
+    With,
+    If,
+    Assert,
+    OpNot,
+    OpEq,
+    OpNEq,
+    OpAnd,
+    OpOr,
+    OpImpl,
+    OpUpdate,
+    OpConcatLists,
+    ConcatStrings,
+    Pos,
+};
+
+
+namespace {
+
+/* Numbers are written as LEB128 varints rather than with the 8-byte
+   encoding of `serialise.hh`: parse trees consist mostly of small
+   numbers (tags, symbol ids, offsets), and this keeps cache entries
+   at roughly the size of the source they were parsed from. */
+
+struct ParsedExprWriter
+{
+    const SymbolTable & symbols;
+    const PosTable::Origin & origin;
+
+    std::string out;
+
+    std::map<Symbol, uint64_t> symbolIds;
+    std::vector<Symbol> symbolOrder;
+
+    /* Some nodes are shared within a tree (e.g. the `ExprInheritFrom`
+       of an `inherit (e) a b;`), so we number nodes in pre-order and
+       refer back to ones that have been written already. */
+    std::unordered_map<const Expr *, uint64_t> exprIds;
+
+    ParsedExprWriter(const SymbolTable & symbols, const PosTable::Origin & origin)
+        : symbols(symbols), origin(origin)
+    { }
+
+    void num(uint64_t n)
+    {
+        while (n >= 0x80) {
+            out.push_back((char) ((n & 0x7f) | 0x80));
+            n >>= 7;
+        }
+        out.push_back((char) n);
+    }
+
+    void str(std::string_view s)
+    {
+        num(s.size());
+        out.append(s);
+    }
+
+    void tag(ExprTag t)
+    {
+        out.push_back((char) t);
+    }
+
+    void sym(Symbol s)
+    {
+        if (!s) {
+            num(0);
+            return;
+        }
+        auto [i, inserted] = symbolIds.try_emplace(s, symbolOrder.size() + 1);
+        if (inserted) symbolOrder.push_back(s);
+        num(i->second);
+    }
+
+    void pos(PosIdx p)
+    {
+        if (!p) {
+            num(0);
+            return;
+        }
+        auto offset = origin.offsetOf(p);
+        if (offset > origin.size)
+            throw SerialisationError("position is outside of the source being serialised");
+        num((uint64_t) offset + 1);
+    }
+
+    void attrPath(const AttrPath & attrPath)
+    {
+        num(attrPath.size());
+        for (auto & i : attrPath) {
+            if (i.symbol) {
+                sym(i.symbol);
+            } else {
+                sym({});
+                expr(i.expr);
+            }
+        }
+    }
+
+    template<typename E>
+    void binOp(ExprTag t, E * e)
+    {
+        tag(t);
+        pos(e->pos);
+        expr(e->e1);
+        expr(e->e2);
+    }
+
+    void expr(Expr * e)
+    {
+        if (!e) {
+            tag(ExprTag::Null);
+            return;
+        }
+
+        if (auto i = exprIds.find(e); i != exprIds.end()) {
+            tag(ExprTag::BackRef);
+            num(i->second);
+            return;
+        }
+        exprIds.emplace(e, exprIds.size());
+
+        if (auto e2 = dynamic_cast<ExprInt *>(e)) {
+            tag(ExprTag::Int);
+            num((uint64_t) e2->v.integer().value);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprFloat *>(e)) {
+            tag(ExprTag::Float);
+            uint64_t bits;
+            auto f = e2->v.fpoint();
+            static_assert(sizeof(bits) == sizeof(f));
+            std::memcpy(&bits, &f, sizeof(bits));
+            num(bits);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprString *>(e)) {
+            tag(ExprTag::String);
+            str(e2->s);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprPath *>(e)) {
+            tag(ExprTag::Path);
+            str(e2->s);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprInheritFrom *>(e)) {
+            tag(ExprTag::InheritFrom);
+            pos(e2->pos);
+            num(e2->displ);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprVar *>(e)) {
+            tag(ExprTag::Var);
+            pos(e2->pos);
+            sym(e2->name);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprSelect *>(e)) {
+            tag(ExprTag::Select);
+            pos(e2->pos);
+            expr(e2->e);
+            attrPath(e2->attrPath);
+            expr(e2->def);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprOpHasAttr *>(e)) {
+            tag(ExprTag::OpHasAttr);
+            expr(e2->e);
+            attrPath(e2->attrPath);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprAttrs *>(e)) {
+            tag(ExprTag::Attrs);
+            attrs(e2);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprList *>(e)) {
+            tag(ExprTag::List);
+            num(e2->elems.size());
+            for (auto & i : e2->elems)
+                expr(i);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprLambda *>(e)) {
+            tag(ExprTag::Lambda);
+            pos(e2->pos);
+            sym(e2->name);
+            sym(e2->arg);
+            if (e2->formals) {
+                num(1);
+                num(e2->formals->ellipsis);
+                num(e2->formals->formals.size());
+                for (auto & i : e2->formals->formals) {
+                    pos(i.pos);
+                    sym(i.name);
+                    expr(i.def);
+                }
+            } else
+                num(0);
+            pos(e2->docComment.begin);
+            pos(e2->docComment.end);
+            expr(e2->body);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprCall *>(e)) {
+            tag(ExprTag::Call);
+            pos(e2->pos);
+            expr(e2->fun);
+            num(e2->args.size());
+            for (auto & i : e2->args)
+                expr(i);
+            /* Only set on calls the parser has warned about; we
+               repeat the warning when loading the tree. */
+            if (e2->cursedOrEndPos) {
+                num(1);
+                pos(*e2->cursedOrEndPos);
+            } else
+                num(0);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprLet *>(e)) {
+            tag(ExprTag::Let);
+            expr(e2->attrs);
+            expr(e2->body);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprWith *>(e)) {
+            tag(ExprTag::With);
+            pos(e2->pos);
+            expr(e2->attrs);
+            expr(e2->body);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprIf *>(e)) {
+            tag(ExprTag::If);
+            pos(e2->pos);
+            expr(e2->cond);
+            expr(e2->then);
+            expr(e2->else_);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprAssert *>(e)) {
+            tag(ExprTag::Assert);
+            pos(e2->pos);
+            expr(e2->cond);
+            expr(e2->body);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprOpNot *>(e)) {
+            tag(ExprTag::OpNot);
+            expr(e2->e);
+        }
+
+        else if (auto e2 = dynamic_cast<ExprOpEq *>(e)) binOp(ExprTag::OpEq, e2);
+        else if (auto e2 = dynamic_cast<ExprOpNEq *>(e)) binOp(ExprTag::OpNEq, e2);
+        else if (auto e2 = dynamic_cast<ExprOpAnd *>(e)) binOp(ExprTag::OpAnd, e2);
+        else if (auto e2 = dynamic_cast<ExprOpOr *>(e)) binOp(ExprTag::OpOr, e2);
+        else if (auto e2 = dynamic_cast<ExprOpImpl *>(e)) binOp(ExprTag::OpImpl, e2);
+        else if (auto e2 = dynamic_cast<ExprOpUpdate *>(e)) binOp(ExprTag::OpUpdate, e2);
+        else if (auto e2 = dynamic_cast<ExprOpConcatLists *>(e)) binOp(ExprTag::OpConcatLists, e2);
+
+        else if (auto e2 = dynamic_cast<ExprConcatStrings *>(e)) {
+            tag(ExprTag::ConcatStrings);
+            pos(e2->pos);
+            num(e2->forceString);
+            num(e2->es->size());
+            for (auto & [p, e3] : *e2->es) {
+                pos(p);
+                expr(e3);
+            }
+        }
+
+        else if (auto e2 = dynamic_cast<ExprPos *>(e)) {
+            tag(ExprTag::Pos);
+            pos(e2->pos);
+        }
+
+        else
+            throw SerialisationError("cannot serialise expression of unknown type");
+    }
+
+    void attrs(ExprAttrs * e)
+    {
+        num(e->recursive);
+        pos(e->pos);
+
+        num(e->attrs.size());
+        for (auto & [name, def] : e->attrs) {
+            sym(name);
+            num((uint64_t) def.kind);
+            pos(def.pos);
+            expr(def.e);
+        }
+
+        if (e->inheritFromExprs) {
+            num(1);
+            num(e->inheritFromExprs->size());
+            for (auto & i : *e->inheritFromExprs)
+                expr(i);
+        } else
+            num(0);
+
+        num(e->dynamicAttrs.size());
+        for (auto & i : e->dynamicAttrs) {
+            pos(i.pos);
+            expr(i.nameExpr);
+            expr(i.valueExpr);
+        }
+    }
+};
+
+
+struct ParsedExprReader
+{
+    std::string_view data;
+    size_t offset = 0;
+
+    SymbolTable & symbols;
+    PosTable & positions;
+    const PosTable::Origin & origin;
+    const ref<SourceAccessor> & rootFS;
+
+    std::vector<Symbol> symbolTable;
+    std::vector<Expr *> exprs;
+
+    ParsedExprReader(
+        std::string_view data,
+        SymbolTable & symbols,
+        PosTable & positions,
+        const PosTable::Origin & origin,
+        const ref<SourceAccessor> & rootFS)
+        : data(data), symbols(symbols), positions(positions), origin(origin), rootFS(rootFS)
+    { }
+
+    [[noreturn]] void corrupt()
+    {
+        throw SerialisationError("parse cache entry is corrupt at offset %d", offset);
+    }
+
+    uint8_t byte()
+    {
+        if (offset >= data.size()) corrupt();
+        return (uint8_t) data[offset++];
+    }
+
+    uint64_t num()
+    {
+        uint64_t n = 0;
+        for (unsigned int shift = 0; ; shift += 7) {
+            if (shift > 63) corrupt();
+            auto b = byte();
+            n |= (uint64_t) (b & 0x7f) << shift;
+            if (!(b & 0x80)) return n;
+        }
+    }
+
+    /**
+     * Read an element count. Every element takes at least one byte,
+     * so this also guards against allocating absurd amounts of
+     * memory for corrupt entries.
+     */
+    size_t count()
+    {
+        auto n = num();
+        if (n > data.size() - offset) corrupt();
+        return n;
+    }
+
+    std::string_view str()
+    {
+        auto n = count();
+        auto s = data.substr(offset, n);
+        offset += n;
+        return s;
+    }
+
+    Symbol sym()
+    {
+        auto n = num();
+        if (!n) return {};
+        if (n > symbolTable.size()) corrupt();
+        return symbolTable[n - 1];
+    }
+
+    PosIdx pos()
+    {
+        auto n = num();
+        if (!n) return noPos;
+        if (n - 1 > origin.size) corrupt();
+        return positions.add(origin, n - 1);
+    }
+
+    AttrPath attrPath()
+    {
+        AttrPath res;
+        auto n = count();
+        res.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (auto s = sym())
+                res.emplace_back(s);
+            else
+                res.emplace_back(expr());
+        }
+        return res;
+    }
+
+    template<typename E>
+    E * expr()
+    {
+        auto e = dynamic_cast<E *>(expr());
+        if (!e) corrupt();
+        return e;
+    }
+
+    template<typename E>
+    Expr * binOp()
+    {
+        auto p = pos();
+        auto e1 = expr();
+        auto e2 = expr();
+        return new E(p, e1, e2);
+    }
+
+    Expr * expr()
+    {
+        auto t = (ExprTag) byte();
+
+        if (t == ExprTag::Null)
+            return nullptr;
+
+        if (t == ExprTag::BackRef) {
+            auto n = num();
+            if (n >= exprs.size() || !exprs[n]) corrupt();
+            return exprs[n];
+        }
+
+        auto id = exprs.size();
+        exprs.push_back(nullptr);
+        auto e = node(t);
+        exprs[id] = e;
+        return e;
+    }
+
+    Expr * node(ExprTag t)
+    {
+        switch (t) {
+
+        case ExprTag::Int:
+            return new ExprInt((NixInt::Inner) num());
+
+        case ExprTag::Float: {
+            auto bits = num();
+            NixFloat f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return new ExprFloat(f);
+        }
+
+        case ExprTag::String:
+            return new ExprString(std::string(str()));
+
+        case ExprTag::Path:
+            return new ExprPath(rootFS, std::string(str()));
+
+        case ExprTag::InheritFrom: {
+            auto p = pos();
+            auto displ = num();
+            if (displ > std::numeric_limits<Displacement>::max()) corrupt();
+            return new ExprInheritFrom(p, (Displacement) displ);
+        }
+
+        case ExprTag::Var: {
+            auto p = pos();
+            return new ExprVar(p, sym());
+        }
+
+        case ExprTag::Select: {
+            auto p = pos();
+            auto e = expr();
+            auto path = attrPath();
+            auto def = expr();
+            return new ExprSelect(p, e, std::move(path), def);
+        }
+
+        case ExprTag::OpHasAttr: {
+            auto e = expr();
+            return new ExprOpHasAttr(e, attrPath());
+        }
+
+        case ExprTag::Attrs:
+            return attrs();
+
+        case ExprTag::List: {
+            auto e = new ExprList;
+            auto n = count();
+            e->elems.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                e->elems.push_back(expr());
+            return e;
+        }
+
+        case ExprTag::Lambda: {
+            auto p = pos();
+            auto name = sym();
+            auto arg = sym();
+            Formals * formals = nullptr;
+            if (num()) {
+                formals = new Formals;
+                formals->ellipsis = num();
+                auto n = count();
+                formals->formals.reserve(n);
+                for (size_t i = 0; i < n; ++i) {
+                    auto fPos = pos();
+                    auto fName = sym();
+                    formals->formals.push_back(Formal{fPos, fName, expr()});
+                }
+            }
+            DocComment docComment;
+            docComment.begin = pos();
+            docComment.end = pos();
+            auto e = new ExprLambda(p, arg, formals, expr());
+            e->name = name;
+            e->docComment = docComment;
+            return e;
+        }
+
+        case ExprTag::Call: {
+            auto p = pos();
+            auto fun = expr();
+            std::vector<Expr *> args;
+            auto n = count();
+            args.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                args.push_back(expr());
+            auto e = new ExprCall(p, fun, std::move(args));
+            if (num()) {
+                e->cursedOrEndPos = pos();
+                e->warnIfCursedOr(symbols, positions);
+            }
+            return e;
+        }
+
+        case ExprTag::Let: {
+            auto attrs = expr<ExprAttrs>();
+            return new ExprLet(attrs, expr());
+        }
+
+        case ExprTag::With: {
+            auto p = pos();
+            auto attrs = expr();
+            return new ExprWith(p, attrs, expr());
+        }
+
+        case ExprTag::If: {
+            auto p = pos();
+            auto cond = expr();
+            auto then = expr();
+            return new ExprIf(p, cond, then, expr());
+        }
+
+        case ExprTag::Assert: {
+            auto p = pos();
+            auto cond = expr();
+            return new ExprAssert(p, cond, expr());
+        }
+
+        case ExprTag::OpNot:
+            return new ExprOpNot(expr());
+
+        case ExprTag::OpEq: return binOp<ExprOpEq>();
+        case ExprTag::OpNEq: return binOp<ExprOpNEq>();
+        case ExprTag::OpAnd: return binOp<ExprOpAnd>();
+        case ExprTag::OpOr: return binOp<ExprOpOr>();
+        case ExprTag::OpImpl: return binOp<ExprOpImpl>();
+        case ExprTag::OpUpdate: return binOp<ExprOpUpdate>();
+        case ExprTag::OpConcatLists: return binOp<ExprOpConcatLists>();
+
+        case ExprTag::ConcatStrings: {
+            auto p = pos();
+            bool forceString = num();
+            auto es = new std::vector<std::pair<PosIdx, Expr *>>;
+            auto n = count();
+            es->reserve(n);
+            for (size_t i = 0; i < n; ++i) {
+                auto p2 = pos();
+                es->emplace_back(p2, expr());
+            }
+            return new ExprConcatStrings(p, forceString, es);
+        }
+
+        case ExprTag::Pos:
+            return new ExprPos(pos());
+
+        default:
+            corrupt();
+        }
+    }
+
+    ExprAttrs * attrs()
+    {
+        auto e = new ExprAttrs;
+        e->recursive = num();
+        e->pos = pos();
+
+        auto n = count();
+        for (size_t i = 0; i < n; ++i) {
+            auto name = sym();
+            auto kind = num();
+            if (kind > (uint64_t) ExprAttrs::AttrDef::Kind::InheritedFrom) corrupt();
+            auto p = pos();
+            e->attrs.emplace(name, ExprAttrs::AttrDef(expr(), p, (ExprAttrs::AttrDef::Kind) kind));
+        }
+
+        if (num()) {
+            e->inheritFromExprs = std::make_unique<std::vector<Expr *>>();
+            auto n = count();
+            e->inheritFromExprs->reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                e->inheritFromExprs->push_back(expr());
+        }
+
+        n = count();
+        for (size_t i = 0; i < n; ++i) {
+            auto p = pos();
+            auto nameExpr = expr();
+            auto valueExpr = expr();
+            e->dynamicAttrs.emplace_back(nameExpr, valueExpr, p);
+        }
+
+        return e;
+    }
+};
+
+}
+
+
+std::string serialiseParsedExpr(
+    Expr * e,
+    const SymbolTable & symbols,
+    const PosTable::Origin & origin,
+    const DocCommentMap & docComments)
+{
+    ParsedExprWriter body(symbols, origin);
+
+    body.expr(e);
+
+    /* The doc comment map of a file is shared by all parses of it,
+       so only take the entries that belong to this origin. */
+    std::vector<std::pair<PosIdx, DocComment>> ourDocComments;
+    for (auto & [pos, comment] : docComments)
+        if (origin.offsetOf(pos) <= origin.size)
+            ourDocComments.emplace_back(pos, comment);
+    body.num(ourDocComments.size());
+    for (auto & [pos, comment] : ourDocComments) {
+        body.pos(pos);
+        body.pos(comment.begin);
+        body.pos(comment.end);
+    }
+
+    ParsedExprWriter header(symbols, origin);
+    header.out.append(parseCacheMagic);
+    header.num(parseCacheVersion);
+    header.num(body.symbolOrder.size());
+    for (auto & s : body.symbolOrder)
+        header.str(symbols[s]);
+
+    return header.out + body.out;
+}
+
+
+Expr * deserialiseParsedExpr(
+    std::string_view data,
+    SymbolTable & symbols,
+    PosTable & positions,
+    const PosTable::Origin & origin,
+    DocCommentMap & docComments,
+    const ref<SourceAccessor> & rootFS)
+{
+    if (!data.starts_with(parseCacheMagic))
+        throw SerialisationError("parse cache entry has an invalid header");
+
+    ParsedExprReader reader(data, symbols, positions, origin, rootFS);
+    reader.offset = parseCacheMagic.size();
+
+    if (reader.num() != parseCacheVersion)
+        throw SerialisationError("parse cache entry has an unsupported version");
+
+    auto nrSymbols = reader.count();
+    reader.symbolTable.reserve(nrSymbols);
+    for (size_t i = 0; i < nrSymbols; ++i)
+        reader.symbolTable.push_back(symbols.create(reader.str()));
+
+    auto e = reader.expr();
+    if (!e) reader.corrupt();
+
+    auto nrDocComments = reader.count();
+    for (size_t i = 0; i < nrDocComments; ++i) {
+        auto pos = reader.pos();
+        DocComment comment;
+        comment.begin = reader.pos();
+        comment.end = reader.pos();
+        docComments.insert_or_assign(pos, comment);
+    }
+
+    if (reader.offset != data.size())
+        reader.corrupt();
+
+    return e;
+}
+
+
+Path getParseCachePath(
+    const SourcePath & path,
+    std::string_view contents,
+    const EvalSettings & settings)
+{
+    HashSink hashSink(HashAlgorithm::SHA256);
+    hashSink
+        << nixVersion
+        << path.to_string()
+        << getHome()
+        << std::string_view(settings.pureEval ? "pure" : "impure")
+        << experimentalFeatureSettings.experimentalFeatures.to_string()
+        << contents;
+    auto hash = hashSink.finish().first;
+    return fmt("%s/parse-cache-v%d/%s", getCacheDir(), parseCacheVersion, hash.to_string(HashFormat::Nix32, false));
+}
+
+
+
+/**
+ * Entries that were used less than this long ago are not marked as
+ * used again, so that most cache hits don't write to the disk.
+ */
+static constexpr time_t parseCacheTouchInterval = 60 * 60;
+
+
+std::optional<std::string> readParseCacheEntry(const Path & cachePath)
+{
+    auto st = maybeLstat(cachePath);
+    if (!st) return std::nullopt;
+
+    auto data = readFile(cachePath);
+
+    auto now = time(nullptr);
+    if (st->st_mtime < now - parseCacheTouchInterval) {
+        try {
+            setWriteTime(cachePath, now, now, false);
+        } catch (SysError & e) {
+            debug("cannot mark parse cache entry '%s' as used: %s", cachePath, e.msg());
+        }
+    }
+
+    return data;
+}
+
+
+/**
+ * Delete the least recently used entries in `dir` until the
+ * remaining ones take up at most `maxSize` bytes.
+ */
+static void pruneParseCache(const Path & dir, uint64_t maxSize)
+{
+    struct Entry
+    {
+        time_t mtime;
+        uint64_t size;
+        Path path;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+
+    for (auto & i : std::filesystem::directory_iterator{dir}) {
+        auto path = i.path().string();
+        auto st = maybeLstat(path);
+        if (!st || !S_ISREG(st->st_mode)) continue;
+        entries.push_back({st->st_mtime, (uint64_t) st->st_size, path});
+        totalSize += st->st_size;
+    }
+
+    if (totalSize <= maxSize) return;
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry & a, const Entry & b) { return a.mtime < b.mtime; });
+
+    for (auto & entry : entries) {
+        if (totalSize <= maxSize) break;
+        debug("deleting parse cache entry '%s'", entry.path);
+        if (unlink(entry.path.c_str()) == 0 || errno == ENOENT)
+            totalSize -= entry.size;
+    }
+}
+
+
+void writeParseCacheEntry(const Path & cachePath, std::string_view data, uint64_t maxSize)
+{
+    auto dir = dirOf(cachePath);
+    createDirs(dir);
+    auto tmpFile = fmt("%s.tmp-%d", cachePath, getpid());
+    writeFile(tmpFile, data);
+    std::filesystem::rename(tmpFile, cachePath);
+
+    /* Prune the cache on the first write of this process, and then
+       whenever another eighth of `maxSize` has been written, so that
+       the cache never grows much beyond `maxSize`. */
+    static std::atomic<uint64_t> bytesWritten = 0;
+    auto interval = std::max<uint64_t>(maxSize / 8, 1);
+    auto before = bytesWritten.fetch_add(data.size());
+    if (before == 0 || before / interval != (before + data.size()) / interval)
+        pruneParseCache(dir, maxSize);
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+///@file
+
+#include "eval.hh"
+
+namespace nix {
+
+/**
+ * Serialise an expression tree as produced by the parser, i.e. before
+ * `Expr::bindVars()` has been called on it, together with the doc
+ * comments found in its source.
+ *
+ * Symbols are stored by name and positions as offsets relative to
+ * `origin`, so the result can be loaded into any `EvalState` that
+ * has an origin for the same source.
+ *
+ * @throws SerialisationError if the tree contains positions outside
+ * of `origin`.
+ */
+std::string serialiseParsedExpr(
+    Expr * e,
+    const SymbolTable & symbols,
+    const PosTable::Origin & origin,
+    const DocCommentMap & docComments);
+
+/**
+ * Inverse of `serialiseParsedExpr()`. Interns the symbols in
+ * `symbols`, resolves positions against `origin` and adds the doc
+ * comments to `docComments`. Warnings that the parser emitted for
+ * the source are emitted again.
+ *
+ * @throws SerialisationError if `data` is truncated or malformed.
+ */
+Expr * deserialiseParsedExpr(
+    std::string_view data,
+    SymbolTable & symbols,
+    PosTable & positions,
+    const PosTable::Origin & origin,
+    DocCommentMap & docComments,
+    const ref<SourceAccessor> & rootFS);
+
+/**
+ * Return the file in which the parse tree of the file `path` with
+ * contents `contents` is cached. The name covers everything that
+ * influences the parser besides the contents: the Nix version, the
+ * path itself (for relative path literals), the home directory (for
+ * `~/` path literals), pure evaluation mode and the enabled
+ * experimental features.
+ */
+Path getParseCachePath(
+    const SourcePath & path,
+    std::string_view contents,
+    const EvalSettings & settings);
+
+/**
+ * Return the contents of the parse cache entry `cachePath`, if it
+ * exists, and mark it as recently used.
+ */
+std::optional<std::string> readParseCacheEntry(const Path & cachePath);
+
+/**
+ * Atomically write the parse cache entry `cachePath`. Whenever the
+ * entries written by this process add up to a fraction of `maxSize`,
+ * the least recently used entries are deleted until the cache takes
+ * up at most `maxSize` bytes.
+ */
+void writeParseCacheEntry(const Path & cachePath, std::string_view data, uint64_t maxSize);
+
+}
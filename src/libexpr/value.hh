@@ -28,8 +28,8 @@ typedef enum {
     tNull,
     tAttrs,
     tList1,
-    tList2,
     tListN,
+    tListConcat,
     tThunk,
     tApp,
     tLambda,
@@ -71,6 +71,7 @@ class StorePath;
 class EvalState;
 class XMLWriter;
 class Printer;
+struct ListConcat;
 
 using NixInt = checked::Checked<int64_t>;
 using NixFloat = double;
@@ -136,7 +137,7 @@ std::ostream & operator << (std::ostream & str, const ExternalValueBase & v);
 class ListBuilder
 {
     const size_t size;
-    Value * inlineElems[2] = {nullptr, nullptr};
+    Value * inlineElems[1] = {nullptr};
 public:
     Value * * elems;
     ListBuilder(EvalState & state, size_t size);
@@ -145,8 +146,8 @@ public:
     // raw pointers.
     ListBuilder(ListBuilder && x) noexcept
         : size(x.size)
-        , inlineElems{x.inlineElems[0], x.inlineElems[1]}
-        , elems(size <= 2 ? inlineElems : x.elems)
+        , inlineElems{x.inlineElems[0]}
+        , elems(size <= 1 ? inlineElems : x.elems)
     { }
 
     Value * & operator [](size_t n)
@@ -163,10 +164,99 @@ public:
 };
 
 
+/**
+ * A Nix value. To keep evaluation memory usage down, a value is only
+ * two words, and its type is encoded in the low bits of the first
+ * word:
+ *
+ * - If these bits are zero, the rest of the first word is the
+ *   `InternalType` and the second word is the payload (an integer, a
+ *   pointer to a set, etc.). An all-zero value is uninitialized.
+ *
+ * - Otherwise, the bits are a `PrimaryDiscriminator` and the value
+ *   has a two-word payload, such as the environment and expression
+ *   of a thunk. The first word then holds a pointer to an object
+ *   that is aligned to at least 8 bytes, so the low bits are
+ *   available. Function applications and primop applications share
+ *   a discriminator; the low bit of their second word tells them
+ *   apart.
+ *
+ * The garbage collector must be told that pointers with these tags
+ * still point to their object (see `initGC()`).
+ */
 struct Value
 {
 private:
-    InternalType internalType = tUninitialized;
+    enum PrimaryDiscriminator : uintptr_t {
+        pdSingleWord = 0,
+        pdString,
+        pdPath,
+        pdListN,
+        pdThunk,
+        pdApp,
+        pdLambda,
+    };
+
+    static constexpr uintptr_t discriminatorMask = 7;
+    static constexpr uintptr_t primOpAppBit = 1;
+
+    uintptr_t word0 = 0;
+
+    union {
+        uintptr_t raw;
+        NixInt integer;
+        bool boolean;
+        NixFloat fpoint;
+        const char * str;
+        Bindings * attrs;
+        Value * smallList[1];
+        ListConcat * listConcat;
+        size_t size;
+        Expr * expr;
+        ExprLambda * fun;
+        PrimOp * primOp;
+        ExternalValueBase * external;
+    } word1 = { .raw = 0 };
+
+    PrimaryDiscriminator discriminator() const
+    {
+        return PrimaryDiscriminator(word0 & discriminatorMask);
+    }
+
+    template<typename T>
+    T * untag() const
+    {
+        return (T *) (word0 & ~discriminatorMask);
+    }
+
+    /**
+     * `p` must be aligned to at least 8 bytes.
+     */
+    template<typename T>
+    void setTwoWords(PrimaryDiscriminator pd, T * p, uintptr_t second)
+    {
+        word0 = (uintptr_t) p | pd;
+        word1.raw = second;
+    }
+
+    void setSingleWord(InternalType type)
+    {
+        word0 = (uintptr_t) type << 3;
+    }
+
+    InternalType internalType() const
+    {
+        switch (discriminator()) {
+            case pdSingleWord: return InternalType(word0 >> 3);
+            case pdString: return tString;
+            case pdPath: return tPath;
+            case pdListN: return tListN;
+            case pdThunk: return tThunk;
+            case pdApp: return word1.raw & primOpAppBit ? tPrimOpApp : tApp;
+            case pdLambda: return tLambda;
+        }
+        unreachable();
+    }
 
     friend std::string showType(const Value & v);
 
@@ -179,14 +269,14 @@ public:
     // needed by callers into methods of this type
 
     // type() == nThunk
-    inline bool isThunk() const { return internalType == tThunk; };
-    inline bool isApp() const { return internalType == tApp; };
+    inline bool isThunk() const { return discriminator() == pdThunk; };
+    inline bool isApp() const { return discriminator() == pdApp && !(word1.raw & primOpAppBit); };
     inline bool isBlackhole() const;
 
     // type() == nFunction
-    inline bool isLambda() const { return internalType == tLambda; };
-    inline bool isPrimOp() const { return internalType == tPrimOp; };
-    inline bool isPrimOpApp() const { return internalType == tPrimOpApp; };
+    inline bool isLambda() const { return discriminator() == pdLambda; };
+    inline bool isPrimOp() const { return word0 == (uintptr_t) tPrimOp << 3; };
+    inline bool isPrimOpApp() const { return discriminator() == pdApp && (word1.raw & primOpAppBit); };
 
     /**
      * Strings in the evaluator carry a so-called `context` which
@@ -234,32 +324,6 @@ public:
         ExprLambda * fun;
     };
 
-    using Payload = union
-    {
-        NixInt integer;
-        bool boolean;
-
-        StringWithContext string;
-
-        Path path;
-
-        Bindings * attrs;
-        struct {
-            size_t size;
-            Value * const * elems;
-        } bigList;
-        Value * smallList[2];
-        ClosureThunk thunk;
-        FunctionApplicationThunk app;
-        Lambda lambda;
-        PrimOp * primOp;
-        FunctionApplicationThunk primOpApp;
-        ExternalValueBase * external;
-        NixFloat fpoint;
-    };
-
-    Payload payload;
-
     /**
      * Returns the normal type of a Value. This only returns nThunk if
      * the Value hasn't been forceValue'd
@@ -269,7 +333,7 @@ public:
      */
     inline ValueType type(bool invalidIsThunk = false) const
     {
-        switch (internalType) {
+        switch (internalType()) {
             case tUninitialized: break;
             case tInt: return nInt;
             case tBool: return nBool;
@@ -277,7 +341,7 @@ public:
             case tPath: return nPath;
             case tNull: return nNull;
             case tAttrs: return nAttrs;
-            case tList1: case tList2: case tListN: return nList;
+            case tList1: case tListN: case tListConcat: return nList;
             case tLambda: case tPrimOp: case tPrimOpApp: return nFunction;
             case tExternal: return nExternal;
             case tFloat: return nFloat;
@@ -289,12 +353,6 @@ public:
             unreachable();
     }
 
-    inline void finishValue(InternalType newType, Payload newPayload)
-    {
-        payload = newPayload;
-        internalType = newType;
-    }
-
     /**
      * A value becomes valid when it is initialized. We don't use this
      * in the evaluator; only in the bindings, where the slight extra
@@ -302,7 +360,7 @@ public:
      */
     inline bool isValid() const
     {
-        return internalType != tUninitialized;
+        return word0 != 0;
     }
 
     inline void mkInt(NixInt::Inner n)
@@ -312,17 +370,19 @@ public:
 
     inline void mkInt(NixInt n)
     {
-        finishValue(tInt, { .integer = n });
+        setSingleWord(tInt);
+        word1.integer = n;
     }
 
     inline void mkBool(bool b)
     {
-        finishValue(tBool, { .boolean = b });
+        setSingleWord(tBool);
+        word1.raw = b;
     }
 
     inline void mkString(const char * s, const char * * context = 0)
     {
-        finishValue(tString, { .string = { .c_str = s, .context = context } });
+        setTwoWords(pdString, context, (uintptr_t) s);
     }
 
     void mkString(std::string_view s);
@@ -341,44 +401,56 @@ public:
 
     inline void mkPath(SourceAccessor * accessor, const char * path)
     {
-        finishValue(tPath, { .path = { .accessor = accessor, .path = path } });
+        setTwoWords(pdPath, accessor, (uintptr_t) path);
     }
 
     inline void mkNull()
     {
-        finishValue(tNull, {});
+        setSingleWord(tNull);
+        word1.raw = 0;
     }
 
     inline void mkAttrs(Bindings * a)
     {
-        finishValue(tAttrs, { .attrs = a });
+        setSingleWord(tAttrs);
+        word1.attrs = a;
     }
 
     Value & mkAttrs(BindingsBuilder & bindings);
 
+    /**
+     * Make this a list that is the concatenation of the lists in
+     * `concat`. The elements are only copied into a single array
+     * when they're first accessed through `listElems()`.
+     */
+    inline void mkListConcat(ListConcat * concat)
+    {
+        setSingleWord(tListConcat);
+        word1.listConcat = concat;
+    }
+
     void mkList(const ListBuilder & builder)
     {
-        if (builder.size == 1)
-            finishValue(tList1, { .smallList = { builder.inlineElems[0] } });
-        else if (builder.size == 2)
-            finishValue(tList2, { .smallList = { builder.inlineElems[0], builder.inlineElems[1] } });
-        else
-            finishValue(tListN, { .bigList = { .size = builder.size, .elems = builder.elems } });
+        if (builder.size == 1) {
+            setSingleWord(tList1);
+            word1.smallList[0] = builder.inlineElems[0];
+        } else
+            setTwoWords(pdListN, builder.elems, builder.size);
     }
 
     inline void mkThunk(Env * e, Expr * ex)
     {
-        finishValue(tThunk, { .thunk = { .env = e, .expr = ex } });
+        setTwoWords(pdThunk, e, (uintptr_t) ex);
     }
 
     inline void mkApp(Value * l, Value * r)
     {
-        finishValue(tApp, { .app = { .left = l, .right = r } });
+        setTwoWords(pdApp, l, (uintptr_t) r);
     }
 
     inline void mkLambda(Env * e, ExprLambda * f)
     {
-        finishValue(tLambda, { .lambda = { .env = e, .fun = f } });
+        setTwoWords(pdLambda, e, (uintptr_t) f);
     }
 
     inline void mkBlackhole();
@@ -387,7 +459,7 @@ public:
 
     inline void mkPrimOpApp(Value * l, Value * r)
     {
-        finishValue(tPrimOpApp, { .primOpApp = { .left = l, .right = r } });
+        setTwoWords(pdApp, l, (uintptr_t) r | primOpAppBit);
     }
 
     /**
@@ -397,22 +469,35 @@ public:
 
     inline void mkExternal(ExternalValueBase * e)
     {
-        finishValue(tExternal, { .external = e });
+        setSingleWord(tExternal);
+        word1.external = e;
     }
 
     inline void mkFloat(NixFloat n)
     {
-        finishValue(tFloat, { .fpoint = n });
+        setSingleWord(tFloat);
+        word1.fpoint = n;
     }
 
     bool isList() const
     {
-        return internalType == tList1 || internalType == tList2 || internalType == tListN;
+        return discriminator() == pdListN || word0 == (uintptr_t) tList1 << 3 || word0 == (uintptr_t) tListConcat << 3;
     }
 
-    Value * const * listElems()
+    /**
+     * Turn a `tListConcat` value into a `tListN` value by copying
+     * the elements of its parts into a single array.
+     */
+    void flattenList() const;
+
+    Value * const * listElems() const
     {
-        return internalType == tList1 || internalType == tList2 ? payload.smallList : payload.bigList.elems;
+        if (discriminator() == pdListN) [[likely]] return untag<Value *>();
+        if (word0 == (uintptr_t) tListConcat << 3) {
+            flattenList();
+            return untag<Value *>();
+        }
+        return word1.smallList;
     }
 
     std::span<Value * const> listItems() const
@@ -421,15 +506,7 @@ public:
         return std::span<Value * const>(listElems(), listSize());
     }
 
-    Value * const * listElems() const
-    {
-        return internalType == tList1 || internalType == tList2 ? payload.smallList : payload.bigList.elems;
-    }
-
-    size_t listSize() const
-    {
-        return internalType == tList1 ? 1 : internalType == tList2 ? 2 : payload.bigList.size;
-    }
+    size_t listSize() const;
 
     PosIdx determinePos(const PosIdx pos) const;
 
@@ -442,54 +519,97 @@ public:
 
     SourcePath path() const
     {
-        assert(internalType == tPath);
+        assert(internalType() == tPath);
         return SourcePath(
-            ref(payload.path.accessor->shared_from_this()),
-            CanonPath(CanonPath::unchecked_t(), payload.path.path));
+            ref(pathAccessor()->shared_from_this()),
+            CanonPath(CanonPath::unchecked_t(), pathStr()));
     }
 
+    SourceAccessor * pathAccessor() const
+    { return untag<SourceAccessor>(); }
+
+    const char * pathStr() const
+    { return word1.str; }
+
     std::string_view string_view() const
     {
-        assert(internalType == tString);
-        return std::string_view(payload.string.c_str);
+        assert(internalType() == tString);
+        return std::string_view(word1.str);
     }
 
     const char * c_str() const
     {
-        assert(internalType == tString);
-        return payload.string.c_str;
+        assert(internalType() == tString);
+        return word1.str;
     }
 
     const char * * context() const
     {
-        return payload.string.context;
+        return untag<const char *>();
     }
 
     ExternalValueBase * external() const
-    { return payload.external; }
+    { return word1.external; }
 
     const Bindings * attrs() const
-    { return payload.attrs; }
+    { return word1.attrs; }
 
     const PrimOp * primOp() const
-    { return payload.primOp; }
+    { return word1.primOp; }
 
     bool boolean() const
-    { return payload.boolean; }
+    { return word1.boolean; }
 
     NixInt integer() const
-    { return payload.integer; }
+    { return word1.integer; }
 
     NixFloat fpoint() const
-    { return payload.fpoint; }
+    { return word1.fpoint; }
+
+    ClosureThunk thunk() const
+    { return { untag<Env>(), word1.expr }; }
+
+    FunctionApplicationThunk app() const
+    { return { untag<Value>(), (Value *) word1.raw }; }
+
+    FunctionApplicationThunk primOpApp() const
+    { return { untag<Value>(), (Value *) (word1.raw & ~primOpAppBit) }; }
+
+    Lambda lambda() const
+    { return { untag<Env>(), word1.fun }; }
+};
+
+static_assert(sizeof(Value) == 2 * sizeof(void *),
+    "the memory usage of the evaluator is dominated by values, so keep them small");
+static_assert(alignof(Value) >= 8 && alignof(Value *) >= 8 && alignof(SourceAccessor) >= 8,
+    "Value uses the low bits of pointers to these types");
+
+
+/**
+ * The parts of a `tListConcat` value. The parts are lists (possibly
+ * `tListConcat` themselves) that are never modified.
+ */
+struct ListConcat
+{
+    size_t size;
+    size_t nrLists;
+    Value lists[0];
 };
 
 
+inline size_t Value::listSize() const
+{
+    if (discriminator() == pdListN) [[likely]] return word1.size;
+    if (word0 == (uintptr_t) tListConcat << 3) return word1.listConcat->size;
+    return 1;
+}
+
+
 extern ExprBlackHole eBlackHole;
 
 bool Value::isBlackhole() const
 {
-    return internalType == tThunk && payload.thunk.expr == (Expr*) &eBlackHole;
+    return isThunk() && word1.expr == (Expr*) &eBlackHole;
 }
 
 void Value::mkBlackhole()
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "filetransfer.hh"
+#include "file-system.hh"
+#include "util.hh"
+
+namespace nix {
+
+/**
+ * A minimal HTTP server on a loopback port. It handles one request
+ * per connection, answers them with `statuses` in turn, and records
+ * the headers and bodies of the requests.
+ */
+class TestHttpServer
+{
+public:
+    struct Request
+    {
+        std::map<std::string, std::string> headers;
+        std::string body;
+    };
+
+private:
+    AutoCloseFD fd;
+    std::thread thread;
+    std::vector<Request> requests;
+
+public:
+    uint16_t port;
+
+    TestHttpServer(std::vector<unsigned int> statuses)
+    {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (!fd) throw SysError("creating socket");
+
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrLen = sizeof(addr);
+        if (bind(fd.get(), (struct sockaddr *) &addr, addrLen) == -1
+            || listen(fd.get(), 8) == -1
+            || getsockname(fd.get(), (struct sockaddr *) &addr, &addrLen) == -1)
+            throw SysError("setting up test HTTP server");
+        port = ntohs(addr.sin_port);
+
+        thread = std::thread([this, statuses]() {
+            for (auto status : statuses) {
+                AutoCloseFD conn = accept(fd.get(), nullptr, nullptr);
+                if (!conn) return;
+                try {
+                    requests.push_back(handle(conn.get(), status));
+                } catch (Error &) {
+                }
+            }
+        });
+    }
+
+    ~TestHttpServer()
+    {
+        /* Wake up accept(). */
+        shutdown(fd.get(), SHUT_RDWR);
+        if (thread.joinable()) thread.join();
+    }
+
+    /**
+     * Wait until all requests have been answered and return them.
+     */
+    std::vector<Request> finish()
+    {
+        thread.join();
+        return std::move(requests);
+    }
+
+    std::string uri(std::string_view path) const
+    {
+        return fmt("http://127.0.0.1:%d/%s", port, path);
+    }
+
+private:
+    static Request handle(int conn, unsigned int status)
+    {
+        Request request;
+
+        readLine(conn);
+        while (true) {
+            auto line = chomp(readLine(conn));
+            if (line.empty()) break;
+            auto colon = line.find(':');
+            if (colon == line.npos) continue;
+            request.headers.insert_or_assign(toLower(line.substr(0, colon)), trim(line.substr(colon + 1)));
+        }
+
+        if (request.headers["expect"] == "100-continue")
+            writeFull(conn, "HTTP/1.1 100 Continue\r\n\r\n");
+
+        auto readBytes = [&](size_t n) {
+            std::string s(n, 0);
+            readFull(conn, s.data(), n);
+            request.body += s;
+        };
+
+        if (request.headers["transfer-encoding"] == "chunked") {
+            while (auto size = std::stoul(chomp(readLine(conn)), nullptr, 16)) {
+                readBytes(size);
+                readLine(conn);
+            }
+            readLine(conn);
+        } else if (request.headers.count("content-length"))
+            readBytes(std::stoul(request.headers["content-length"]));
+
+        writeFull(conn, fmt("HTTP/1.1 %d Test\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status));
+
+        return request;
+    }
+};
+
+class FileTransferUploadTest : public ::testing::Test
+{
+protected:
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir{tmpDir};
+
+    /* Bigger than curl's upload buffer. */
+    std::string contents = []() {
+        std::string s;
+        for (int i = 0; s.size() < 4 << 20; ++i)
+            s += fmt("%d\n", i);
+        return s;
+    }();
+
+    std::shared_ptr<std::istream> openContents()
+    {
+        auto path = tmpDir + "/upload";
+        writeFile(path, contents);
+        return std::make_shared<std::ifstream>(path, std::ios_base::in | std::ios_base::binary);
+    }
+};
+
+TEST_F(FileTransferUploadTest, streamsBody)
+{
+    TestHttpServer server({200});
+    FileTransferRequest request(server.uri("upload"));
+    request.dataStream = openContents();
+    makeFileTransfer()->upload(request);
+    auto requests = server.finish();
+
+    ASSERT_EQ(requests.size(), 1);
+    ASSERT_EQ(requests[0].headers["content-length"], std::to_string(contents.size()));
+    ASSERT_EQ(requests[0].body, contents);
+}
+
+TEST_F(FileTransferUploadTest, retryRewindsStream)
+{
+    TestHttpServer server({500, 200});
+    FileTransferRequest request(server.uri("upload"));
+    request.dataStream = openContents();
+    request.baseRetryTimeMs = 0;
+    makeFileTransfer()->upload(request);
+    auto requests = server.finish();
+
+    ASSERT_EQ(requests.size(), 2);
+    for (auto & r : requests)
+        ASSERT_EQ(r.body, contents);
+}
+
+} // namespace nix
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
 #include "local-binary-cache-store.hh"
+#include "nar-info.hh"
+#include "file-system.hh"
+#include "source-path.hh"
 
 namespace nix {
 
@@ -11,4 +14,98 @@ TEST(LocalBinaryCacheStore, constructConfig)
     EXPECT_EQ(config.binaryCacheDir, "/foo/bar/baz");
 }
 
+class SeekableNarTest : public ::testing::Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        initLibStore(false);
+    }
+
+protected:
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir{tmpDir};
+
+    /* Big enough to span several frames. */
+    std::string big = []() {
+        std::string s;
+        for (int i = 0; s.size() < 3 << 20; ++i)
+            s += fmt("%d\n", i);
+        return s;
+    }();
+
+    ref<Store> openCache(std::string_view params)
+    {
+        return openStore(fmt("file://%s/cache?%s", tmpDir, params));
+    }
+
+    StorePath addPath(Store & store)
+    {
+        auto dir = tmpDir + "/src";
+        createDirs(dir);
+        writeFile(dir + "/big", big);
+        writeFile(dir + "/small", "hello");
+        createSymlink("small", dir + "/link");
+        return store.addToStore("seekable", SourcePath{getFSSourceAccessor(), CanonPath(dir)});
+    }
+
+    static CanonPath inPath(Store & store, const StorePath & path, std::string_view file)
+    {
+        return CanonPath(store.printStorePath(path)) / file;
+    }
+};
+
+TEST_F(SeekableNarTest, readsFileRange)
+{
+    auto store = openCache("compression=zstd&seekable-compression=true");
+    auto path = addPath(*store);
+
+    auto info = std::dynamic_pointer_cast<const NarInfo>(store->queryPathInfo(path).get_ptr());
+    ASSERT_TRUE(info);
+    auto nar = readFile(tmpDir + "/cache/" + info->url);
+
+    auto range = store.cast<BinaryCacheStore>()->getFileRange(info->url, 1000, 2000);
+    ASSERT_TRUE(range);
+    ASSERT_EQ(*range, nar.substr(1000, 2000));
+}
+
+TEST_F(SeekableNarTest, readsFilesWithoutFullNar)
+{
+    auto store = openCache("compression=zstd&seekable-compression=true&write-nar-listing=true");
+    auto path = addPath(*store);
+
+    auto accessor = store.cast<BinaryCacheStore>()->getSeekableNarAccessor(path);
+    ASSERT_TRUE(accessor);
+    ASSERT_EQ(accessor->readFile(CanonPath("/small")), "hello");
+    ASSERT_EQ(accessor->readFile(CanonPath("/big")), big);
+    ASSERT_EQ(accessor->readLink(CanonPath("/link")), "small");
+
+    auto fsAccessor = store->getFSAccessor();
+    ASSERT_EQ(fsAccessor->readFile(inPath(*store, path, "small")), "hello");
+    ASSERT_EQ(fsAccessor->readFile(inPath(*store, path, "big")), big);
+}
+
+TEST_F(SeekableNarTest, needsSeekableCompression)
+{
+    auto store = openCache("compression=zstd&write-nar-listing=true");
+    auto path = addPath(*store);
+
+    ASSERT_FALSE(store.cast<BinaryCacheStore>()->getSeekableNarAccessor(path));
+    ASSERT_EQ(store->getFSAccessor()->readFile(inPath(*store, path, "small")), "hello");
+}
+
+TEST_F(SeekableNarTest, malformedListingFallsBackToFullNar)
+{
+    auto store = openCache("compression=zstd&seekable-compression=true&write-nar-listing=true");
+    auto path = addPath(*store);
+
+    writeFile(fmt("%s/cache/%s.ls", tmpDir, path.hashPart()), R"({"version":1,"root":{"type":"regular"}})");
+    ASSERT_FALSE(store.cast<BinaryCacheStore>()->getSeekableNarAccessor(path));
+
+    writeFile(fmt("%s/cache/%s.ls", tmpDir, path.hashPart()), "{");
+    ASSERT_FALSE(store.cast<BinaryCacheStore>()->getSeekableNarAccessor(path));
+
+    ASSERT_EQ(store->getFSAccessor()->readFile(inPath(*store, path, "small")), "hello");
+}
+
 } // namespace nix
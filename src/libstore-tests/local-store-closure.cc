@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "local-store.hh"
+#include "file-system.hh"
+
+namespace nix {
+
+class LocalStoreClosureTest : public ::testing::Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        initLibStore(false);
+    }
+
+protected:
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir{tmpDir};
+
+    ref<LocalStore> store = openStore("local", {
+        {"store", tmpDir + "/store"},
+        {"state", tmpDir + "/state"},
+        {"log", tmpDir + "/log"},
+    }).cast<LocalStore>();
+
+    /* The registered paths don't need to exist on disk. */
+    StorePath add(std::string_view name, StorePathSet references = {})
+    {
+        ValidPathInfo info{StorePath::random(name), UnkeyedValidPathInfo(Hash(HashAlgorithm::SHA256))};
+        info.references = std::move(references);
+        store->registerValidPath(info);
+        return info.path;
+    }
+};
+
+TEST_F(LocalStoreClosureTest, sharedClosure)
+{
+    auto c = add("c");
+    auto b = add("b", {c});
+    auto a = add("a", {b});
+    auto d = add("d", {b, c});
+    auto e = add("e");
+
+    StorePathSet closure;
+    store->computeFSClosure({a, d}, closure);
+    ASSERT_EQ(closure, (StorePathSet{a, b, c, d}));
+
+    StorePathSet referrers;
+    store->computeFSClosure({c}, referrers, true);
+    ASSERT_EQ(referrers, (StorePathSet{a, b, c, d}));
+
+    /* Paths already in the output are not queried again. */
+    StorePathSet more{e};
+    store->computeFSClosure({e, b}, more);
+    ASSERT_EQ(more, (StorePathSet{b, c, e}));
+}
+
+TEST_F(LocalStoreClosureTest, manyStartPaths)
+{
+    auto base = add("base");
+
+    StorePathSet startPaths;
+    for (int i = 0; i < 1200; ++i)
+        startPaths.insert(add("top", {base}));
+
+    StorePathSet closure;
+    store->computeFSClosure(startPaths, closure);
+
+    auto expected = startPaths;
+    expected.insert(base);
+    ASSERT_EQ(closure, expected);
+}
+
+TEST_F(LocalStoreClosureTest, invalidStartPath)
+{
+    auto missing = StorePath::random("missing");
+
+    StorePathSet closure;
+    ASSERT_THROW(store->computeFSClosure({missing}, closure), InvalidPath);
+
+    StorePathSet referrers;
+    store->computeFSClosure({missing}, referrers, true);
+    ASSERT_EQ(referrers, StorePathSet{missing});
+}
+
+} // namespace nix
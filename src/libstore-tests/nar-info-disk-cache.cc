@@ -120,4 +120,95 @@ TEST(NarInfoDiskCacheImpl, create_and_read) {
     }
 }
 
+TEST(NarInfoDiskCacheImpl, lookupNarInfos) {
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir(tmpDir);
+
+    auto cache = getTestNarInfoDiskCache(tmpDir + "/test-narinfo-disk-cache.sqlite");
+    cache->createCache("http://foo", "/nix/store", true, 10);
+
+    std::string valid = "g1w7hy3qg1w7hy3qg1w7hy3qg1w7hy3q";
+    std::string invalid = "ffffffffffffffffffffffffffffffff";
+    std::string unknown = "00000000000000000000000000000000";
+
+    auto info = std::make_shared<NarInfo>(
+        StorePath(valid + "-foo"),
+        Hash::parseAnyPrefixed("sha256-FePFYIlMuycIXPZbWi7LGEiMmZSX9FMbaQenWBzm1Sc="));
+    info->url = "nar/foo.nar.xz";
+    cache->upsertNarInfo("http://foo", valid, info);
+    cache->upsertNarInfo("http://foo", invalid, nullptr);
+
+    auto res = cache->lookupNarInfos("http://foo", {valid, invalid, unknown});
+    ASSERT_EQ(res.size(), 3);
+
+    ASSERT_EQ(res[valid].first, NarInfoDiskCache::oValid);
+    ASSERT_EQ(res[valid].second->path, info->path);
+    ASSERT_EQ(res[valid].second->url, info->url);
+
+    ASSERT_EQ(res[invalid].first, NarInfoDiskCache::oInvalid);
+    ASSERT_EQ(res[unknown].first, NarInfoDiskCache::oUnknown);
+
+    /* The bulk lookup agrees with the single lookups. */
+    for (auto & [hashPart, r] : res)
+        ASSERT_EQ(cache->lookupNarInfo("http://foo", hashPart).first, r.first);
+}
+
+TEST(NarInfoDiskCacheImpl, upsertNarInfos) {
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir(tmpDir);
+
+    auto cache = getTestNarInfoDiskCache(tmpDir + "/test-narinfo-disk-cache.sqlite");
+    cache->createCache("http://foo", "/nix/store", true, 10);
+
+    std::string valid = "g1w7hy3qg1w7hy3qg1w7hy3qg1w7hy3q";
+    std::string invalid = "ffffffffffffffffffffffffffffffff";
+
+    auto info = std::make_shared<NarInfo>(
+        StorePath(valid + "-foo"),
+        Hash::parseAnyPrefixed("sha256-FePFYIlMuycIXPZbWi7LGEiMmZSX9FMbaQenWBzm1Sc="));
+    info->url = "nar/foo.nar.xz";
+    cache->upsertNarInfos("http://foo", {{valid, info}, {invalid, nullptr}});
+
+    auto res = cache->lookupNarInfo("http://foo", valid);
+    ASSERT_EQ(res.first, NarInfoDiskCache::oValid);
+    ASSERT_EQ(res.second->path, info->path);
+    ASSERT_EQ(res.second->url, info->url);
+
+    ASSERT_EQ(cache->lookupNarInfo("http://foo", invalid).first, NarInfoDiskCache::oInvalid);
+}
+
+TEST(NarInfoDiskCacheImpl, queryStats) {
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir(tmpDir);
+    Path dbPath(tmpDir + "/test-narinfo-disk-cache.sqlite");
+
+    QueryStats stats;
+    for (int i = 0; i < 20; ++i)
+        stats.record(std::chrono::milliseconds(100 + i), i % 5 == 0);
+
+    {
+        auto cache = getTestNarInfoDiskCache(dbPath);
+        cache->createCache("http://foo", "/nix/store", true, 10);
+        ASSERT_FALSE(cache->lookupQueryStats("http://foo"));
+
+        cache->upsertQueryStats("http://foo", stats);
+    }
+
+    {
+        auto cache = getTestNarInfoDiskCache(dbPath);
+        cache->createCache("http://foo", "/nix/store", true, 10);
+
+        auto r = cache->lookupQueryStats("http://foo");
+        ASSERT_TRUE(r);
+        ASSERT_EQ(r->nrQueries, stats.nrQueries);
+        ASSERT_EQ(r->nrErrors, stats.nrErrors);
+        ASSERT_NEAR(r->latencyMean, stats.latencyMean, 0.001);
+        ASSERT_NEAR(r->latencyDeviation, stats.latencyDeviation, 0.001);
+
+        /* Re-registering the cache keeps its statistics. */
+        cache->createCache("http://foo", "/nix/store", false, 20);
+        ASSERT_TRUE(cache->lookupQueryStats("http://foo"));
+    }
+}
+
 }
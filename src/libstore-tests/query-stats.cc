@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "query-stats.hh"
+
+namespace nix {
+
+using namespace std::chrono_literals;
+
+TEST(QueryStats, patientWithoutSamples)
+{
+    QueryStats stats;
+    ASSERT_EQ(stats.hedgeDelay(), 1000ms);
+
+    stats.record(5ms, false);
+    ASSERT_EQ(stats.hedgeDelay(), 1000ms);
+}
+
+TEST(QueryStats, followsLatency)
+{
+    QueryStats fast, slow;
+    for (int i = 0; i < 100; ++i) {
+        fast.record(20ms, false);
+        slow.record(i % 2 ? 300ms : 500ms, false);
+    }
+
+    ASSERT_NEAR(fast.latencyMean, 20, 0.01);
+    ASSERT_NEAR(fast.latencyDeviation, 0, 0.01);
+    ASSERT_EQ(fast.hedgeDelay(), 20ms);
+
+    /* The jitter pushes the delay above the mean. */
+    ASSERT_GT(slow.hedgeDelay(), 500ms);
+    ASSERT_LT(slow.hedgeDelay(), 1500ms);
+}
+
+TEST(QueryStats, delayIsClamped)
+{
+    QueryStats fast, slow;
+    for (int i = 0; i < 10; ++i) {
+        fast.record(0.1ms, false);
+        slow.record(60s, false);
+    }
+    ASSERT_EQ(fast.hedgeDelay(), 10ms);
+    ASSERT_EQ(slow.hedgeDelay(), 10s);
+}
+
+TEST(QueryStats, failingStoreIsNotWaitedFor)
+{
+    QueryStats stats;
+    for (int i = 0; i < 10; ++i)
+        stats.record(20ms, false);
+    for (int i = 0; i < 11; ++i)
+        stats.record(0ms, true);
+    ASSERT_EQ(stats.hedgeDelay(), 0ms);
+
+    /* Errors are forgotten eventually. */
+    for (int i = 0; i < 100; ++i)
+        stats.record(20ms, false);
+    ASSERT_EQ(stats.hedgeDelay(), 20ms);
+    ASSERT_LE(stats.nrQueries, QueryStats::window);
+}
+
+}
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "references.hh"
+
+namespace nix {
+
+/**
+ * Return `size` bytes of data in which half of `hashes` occur, so
+ * that the scanner has to go through all of it.
+ */
+static std::string makeData(size_t size, const StringSet & hashes, bool nix32Only, std::mt19937 & rng)
+{
+    std::string data(size, 0);
+    for (auto & c : data)
+        c = nix32Only ? nix32Chars[rng() % nix32Chars.size()] : (char) rng();
+
+    size_t n = 0;
+    for (auto & hash : hashes)
+        if (n++ % 2 == 0)
+            data.replace(rng() % (size - hash.size()), hash.size(), hash);
+
+    return data;
+}
+
+static StringSet makeHashes(size_t nrHashes, std::mt19937 & rng)
+{
+    StringSet hashes;
+    while (hashes.size() < nrHashes) {
+        std::string hash(RefScanSink::refLength, 0);
+        for (auto & c : hash)
+            c = nix32Chars[rng() % nix32Chars.size()];
+        hashes.insert(hash);
+    }
+    return hashes;
+}
+
+/**
+ * Scan the data in 64 KiB chunks, as when scanning a NAR for
+ * references. Arguments: data size, number of hash parts, and
+ * whether the data consists only of nix32 characters (the worst
+ * case, since every position starts a candidate).
+ */
+static void BM_RefScanSink(benchmark::State & state)
+{
+    auto size = (size_t) state.range(0);
+    auto nrHashes = (size_t) state.range(1);
+    auto nix32Only = (bool) state.range(2);
+
+    std::mt19937 rng(42);
+    auto hashes = makeHashes(nrHashes, rng);
+    auto data = makeData(size, hashes, nix32Only, rng);
+
+    const size_t chunkSize = 64 * 1024;
+
+    for (auto _ : state) {
+        RefScanSink sink{StringSet(hashes)};
+        for (size_t pos = 0; pos < data.size(); pos += chunkSize)
+            sink(std::string_view(data).substr(pos, chunkSize));
+        benchmark::DoNotOptimize(sink.getResult());
+    }
+
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_RefScanSink)
+    ->ArgNames({"size", "hashes", "nix32"})
+    ->Args({1 << 20, 10, 0})
+    ->Args({16 << 20, 10, 0})
+    ->Args({16 << 20, 1000, 0})
+    ->Args({16 << 20, 10, 1})
+    ->Args({16 << 20, 1000, 1});
+
+}
+
+BENCHMARK_MAIN();
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 namespace nix {
 
 TEST(references, scan)
@@ -42,4 +44,57 @@ TEST(references, scan)
     }
 }
 
+TEST(references, scanLarge)
+{
+    std::mt19937 rng(42);
+
+    auto randomHash = [&]() {
+        std::string s;
+        for (size_t i = 0; i < RefScanSink::refLength; ++i)
+            s += nix32Chars[rng() % nix32Chars.size()];
+        return s;
+    };
+
+    StringSet hashes, expected;
+    for (int i = 0; i < 100; ++i)
+        hashes.insert(randomHash());
+
+    /* Mostly nix32 characters, so that there are many candidates
+       that aren't references, interspersed with some references. */
+    std::string s;
+    for (auto & hash : hashes) {
+        for (int i = 0; i < 1000; ++i)
+            s += rng() % 50 ? nix32Chars[rng() % nix32Chars.size()] : (char) rng();
+        if (rng() % 2) {
+            s += hash;
+            expected.insert(hash);
+        }
+    }
+
+    {
+        RefScanSink scanner{StringSet(hashes)};
+        scanner(s);
+        ASSERT_EQ(scanner.getResult(), expected);
+    }
+
+    /* Chunk boundaries shouldn't matter. */
+    for (size_t chunkSize : {1, 7, 31, 32, 63, 64, 65, 4096}) {
+        RefScanSink scanner{StringSet(hashes)};
+        for (size_t i = 0; i < s.size(); i += chunkSize)
+            scanner(((std::string_view) s).substr(i, chunkSize));
+        ASSERT_EQ(scanner.getResult(), expected);
+    }
+}
+
+TEST(references, scanNonNix32)
+{
+    std::string hash = "dc04vv14dak1c1r48qa0m23vr9jy8sm0";
+
+    /* 'e' is not a nix32 character. */
+    RefScanSink scanner(StringSet{hash});
+    auto s = "dc04vv14dak1c1r48qa0m23vr9jy8sme\xff" + hash.substr(1) + "\x80" + hash.substr(0, 31);
+    scanner(s);
+    ASSERT_EQ(scanner.getResult(), StringSet{});
+}
+
 }
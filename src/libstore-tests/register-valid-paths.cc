@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "local-store.hh"
+#include "file-system.hh"
+
+namespace nix {
+
+class RegisterValidPathsTest : public ::testing::Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        initLibStore(false);
+    }
+
+protected:
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir{tmpDir};
+
+    ref<LocalStore> store = openStore("local", {
+        {"store", tmpDir + "/store"},
+        {"state", tmpDir + "/state"},
+        {"log", tmpDir + "/log"},
+    }).cast<LocalStore>();
+
+    /* The registered paths don't need to exist on disk. */
+    static ValidPathInfo makeInfo(std::string_view name, StorePathSet references = {})
+    {
+        ValidPathInfo info{StorePath::random(name), UnkeyedValidPathInfo(Hash(HashAlgorithm::SHA256))};
+        info.references = std::move(references);
+        return info;
+    }
+};
+
+TEST_F(RegisterValidPathsTest, failedRegistrationIsRolledBack)
+{
+    auto a = makeInfo("a");
+    auto b = makeInfo("b", {StorePath::random("missing")});
+
+    ValidPathInfos infos;
+    infos.emplace(a.path, a);
+    infos.emplace(b.path, b);
+    ASSERT_THROW(store->registerValidPaths(infos), Error);
+
+    ASSERT_FALSE(store->isValidPath(a.path));
+    ASSERT_FALSE(store->isValidPath(b.path));
+
+    store->registerValidPath(a);
+    ASSERT_TRUE(store->isValidPath(a.path));
+}
+
+TEST_F(RegisterValidPathsTest, concurrentRegistrationsAreIsolated)
+{
+    auto base = makeInfo("base");
+    store->registerValidPath(base);
+
+    /* Every other registration refers to a path that isn't valid.
+       It must fail without affecting the registrations committed in
+       the same transaction. */
+    constexpr int nrThreads = 16, nrPaths = 20;
+    std::vector<std::vector<StorePath>> registered(nrThreads), failed(nrThreads);
+    std::atomic<int> wrongErrors = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nrThreads; ++t)
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < nrPaths; ++i) {
+                auto info = i % 2
+                    ? makeInfo("bad", {base.path, StorePath::random("missing")})
+                    : makeInfo("good", {base.path});
+                try {
+                    store->registerValidPath(info);
+                    registered[t].push_back(info.path);
+                } catch (Error &) {
+                    failed[t].push_back(info.path);
+                    if (!(i % 2))
+                        wrongErrors++;
+                }
+            }
+        });
+    for (auto & thread : threads)
+        thread.join();
+
+    ASSERT_EQ(wrongErrors, 0);
+
+    StorePathSet referrers;
+    store->queryReferrers(base.path, referrers);
+
+    for (int t = 0; t < nrThreads; ++t) {
+        ASSERT_EQ(registered[t].size(), nrPaths / 2);
+        ASSERT_EQ(failed[t].size(), nrPaths / 2);
+        for (auto & path : registered[t]) {
+            ASSERT_TRUE(store->isValidPath(path));
+            ASSERT_TRUE(referrers.count(path));
+        }
+        for (auto & path : failed[t])
+            ASSERT_FALSE(store->isValidPath(path));
+    }
+
+    ASSERT_EQ(referrers.size(), nrThreads * nrPaths / 2);
+}
+
+} // namespace nix
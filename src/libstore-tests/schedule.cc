@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "schedule.hh"
+
+namespace nix {
+
+using namespace std::chrono_literals;
+
+static StorePath drv(std::string_view name)
+{
+    return StorePath{"g1w7hy3qg1w7hy3qg1w7hy3qg1w7hy3q-" + std::string(name) + ".drv"};
+}
+
+/* A chain `a` <- `b` <- `c` of 10 second builds, and five unrelated
+   3 second builds. */
+static std::map<StorePath, ScheduleNode> chainAndLeaves()
+{
+    std::map<StorePath, ScheduleNode> nodes;
+    nodes.insert_or_assign(drv("a"), ScheduleNode{.duration = 10s});
+    nodes.insert_or_assign(drv("b"), ScheduleNode{.duration = 10s, .inputs = {drv("a")}});
+    nodes.insert_or_assign(drv("c"), ScheduleNode{.duration = 10s, .inputs = {drv("b")}});
+    for (auto leaf : {"l1", "l2", "l3", "l4", "l5"})
+        nodes.insert_or_assign(drv(leaf), ScheduleNode{.duration = 3s});
+    return nodes;
+}
+
+TEST(Schedule, criticalPathLengths)
+{
+    auto lengths = criticalPathLengths(chainAndLeaves());
+
+    ASSERT_EQ(lengths.at(drv("a")), 30s);
+    ASSERT_EQ(lengths.at(drv("b")), 20s);
+    ASSERT_EQ(lengths.at(drv("c")), 10s);
+    ASSERT_EQ(lengths.at(drv("l1")), 3s);
+}
+
+TEST(Schedule, startsCriticalPathFirst)
+{
+    auto schedule = simulateSchedule(chainAndLeaves(), 2);
+
+    ASSERT_EQ(schedule.entries.size(), 8);
+    ASSERT_EQ(schedule.entries[0].drvPath, drv("a"));
+    ASSERT_EQ(schedule.entries[0].start, 0s);
+
+    /* The leaves fit next to the chain. */
+    ASSERT_EQ(schedule.makespan, 30s);
+}
+
+TEST(Schedule, diamond)
+{
+    std::map<StorePath, ScheduleNode> nodes;
+    nodes.insert_or_assign(drv("top"), ScheduleNode{.duration = 1s, .inputs = {drv("left"), drv("right")}});
+    nodes.insert_or_assign(drv("left"), ScheduleNode{.duration = 5s, .inputs = {drv("bottom")}});
+    nodes.insert_or_assign(drv("right"), ScheduleNode{.duration = 2s, .inputs = {drv("bottom")}});
+    nodes.insert_or_assign(drv("bottom"), ScheduleNode{.duration = 4s});
+
+    ASSERT_EQ(criticalPathLengths(nodes).at(drv("bottom")), 10s);
+    ASSERT_EQ(simulateSchedule(nodes, 4).makespan, 10s);
+    ASSERT_EQ(simulateSchedule(nodes, 1).makespan, 12s);
+}
+
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "system-load.hh"
+
+namespace nix {
+
+TEST(SystemLoad, parsePressure)
+{
+    ASSERT_EQ(
+        parsePressure(
+            "some avg10=12.50 avg60=3.00 avg300=1.00 total=123456\n"
+            "full avg10=2.00 avg60=1.00 avg300=0.00 total=23456\n"),
+        12.5);
+    ASSERT_EQ(parsePressure("full avg10=2.00 avg60=1.00 avg300=0.00 total=23456\n"), std::nullopt);
+    ASSERT_EQ(parsePressure(""), std::nullopt);
+}
+
+TEST(SystemLoad, parseMemAvailable)
+{
+    ASSERT_EQ(
+        parseMemAvailable(
+            "MemTotal:       32768000 kB\n"
+            "MemFree:         1024000 kB\n"
+            "MemAvailable:    2048000 kB\n"),
+        2048000ULL * 1024);
+    ASSERT_EQ(parseMemAvailable("MemTotal:       32768000 kB\n"), std::nullopt);
+}
+
+TEST(SystemLoad, checkBuildAdmission)
+{
+    SystemLoad load{
+        .loadAverage = 10,
+        .availableMemory = 4ULL << 30,
+        .cpuPressure = 5,
+        .memoryPressure = 30,
+    };
+
+    /* Disabled limits admit everything. */
+    ASSERT_EQ(checkBuildAdmission(load, 0, 0, 0), std::nullopt);
+
+    ASSERT_EQ(checkBuildAdmission(load, 16, 0, 0), std::nullopt);
+    ASSERT_NE(checkBuildAdmission(load, 8, 0, 0), std::nullopt);
+
+    ASSERT_EQ(checkBuildAdmission(load, 0, 2ULL << 30, 0), std::nullopt);
+    ASSERT_NE(checkBuildAdmission(load, 0, 8ULL << 30, 0), std::nullopt);
+
+    ASSERT_NE(checkBuildAdmission(load, 0, 0, 20), std::nullopt);
+    ASSERT_EQ(checkBuildAdmission(load, 0, 0, 50), std::nullopt);
+
+    /* Unknown measurements don't block builds. */
+    ASSERT_EQ(checkBuildAdmission(SystemLoad{}, 1, 1ULL << 40, 1), std::nullopt);
+}
+
+TEST(SystemLoad, burstIsAdmittedOneBuildPerMeasurement)
+{
+    using namespace std::chrono_literals;
+
+    size_t nrMeasurements = 0;
+    BuildAdmission admission([&]() {
+        nrMeasurements++;
+        return SystemLoad{.loadAverage = 1};
+    }, 1s);
+
+    auto now = BuildAdmission::Clock::now();
+
+    /* The first build never depends on the load. */
+    ASSERT_EQ(admission.check(0, 8, 0, 0, now), std::nullopt);
+    admission.buildStarted();
+
+    /* Nor does anything if no limit is set. */
+    ASSERT_EQ(admission.check(1, 0, 0, 0, now), std::nullopt);
+    ASSERT_EQ(nrMeasurements, 0);
+
+    /* A burst of goals wanting to build while the load is low gets
+       only one build per measurement. */
+    size_t nrRunning = 1;
+    for (int i = 0; i < 10; ++i)
+        if (!admission.check(nrRunning, 8, 0, 0, now)) {
+            admission.buildStarted();
+            nrRunning++;
+        }
+    ASSERT_EQ(nrRunning, 2);
+    ASSERT_EQ(nrMeasurements, 1);
+
+    now += 1s;
+    for (int i = 0; i < 10; ++i)
+        if (!admission.check(nrRunning, 8, 0, 0, now)) {
+            admission.buildStarted();
+            nrRunning++;
+        }
+    ASSERT_EQ(nrRunning, 3);
+    ASSERT_EQ(nrMeasurements, 2);
+
+    /* Checking alone doesn't use up the measurement. */
+    now += 1s;
+    ASSERT_EQ(admission.check(nrRunning, 8, 0, 0, now), std::nullopt);
+    ASSERT_EQ(admission.check(nrRunning, 8, 0, 0, now), std::nullopt);
+}
+
+TEST(SystemLoad, busySystemAdmitsNothing)
+{
+    using namespace std::chrono_literals;
+
+    BuildAdmission admission([&]() { return SystemLoad{.loadAverage = 20}; }, 1s);
+
+    auto now = BuildAdmission::Clock::now();
+    ASSERT_EQ(admission.check(0, 8, 0, 0, now), std::nullopt);
+    for (int i = 0; i < 3; ++i, now += 1s)
+        ASSERT_NE(admission.check(1, 8, 0, 0, now), std::nullopt);
+}
+
+TEST(SystemLoad, adaptBuildCores)
+{
+    ASSERT_EQ(adaptBuildCores(8, 16, 12.0), 8);
+    ASSERT_EQ(adaptBuildCores(8, 16, std::nullopt), 8);
+    ASSERT_EQ(adaptBuildCores(8, 16, 32.0), 4);
+    ASSERT_EQ(adaptBuildCores(0, 16, 32.0), 8);
+    ASSERT_EQ(adaptBuildCores(2, 16, 1000.0), 1);
+}
+
+}
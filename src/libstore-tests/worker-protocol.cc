@@ -9,6 +9,9 @@
 #include "worker-protocol-impl.hh"
 #include "derived-path.hh"
 #include "build-result.hh"
+#include "daemon.hh"
+#include "local-store.hh"
+#include "file-system.hh"
 #include "tests/protocol.hh"
 #include "tests/characterization.hh"
 
@@ -776,4 +779,138 @@ TEST_F(WorkerProtoTest, handshake_client_corrupted_throws)
     });
 }
 
+/**
+ * Runs the daemon side of the protocol in a thread, against a local
+ * store in a temporary directory.
+ */
+class WorkerProtoDaemonTest : public ::testing::Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        initLibStore(false);
+    }
+
+protected:
+    Path tmpDir = createTempDir();
+    AutoDelete delTmpDir{tmpDir};
+
+    std::set<Xp> oldFeatures;
+    std::shared_ptr<LocalStore> store;
+
+    Pipe toClient, toServer;
+    std::thread daemonThread;
+
+    struct Connection : WorkerProto::BasicClientConnection
+    {
+        AutoCloseFD & writeSide;
+
+        Connection(AutoCloseFD & writeSide) : writeSide(writeSide) { }
+
+        void closeWrite() override
+        {
+            writeSide.close();
+        }
+    };
+
+    Connection conn{toServer.writeSide};
+
+    void SetUp() override
+    {
+        /* Realisations are only stored with this feature. */
+        oldFeatures = experimentalFeatureSettings.experimentalFeatures.get();
+        experimentalFeatureSettings.set("extra-experimental-features", "ca-derivations");
+
+        store = openStore("local", {
+            {"store", tmpDir + "/store"},
+            {"state", tmpDir + "/state"},
+            {"log", tmpDir + "/log"},
+        }).cast<LocalStore>();
+
+        toClient.create();
+        toServer.create();
+
+        daemonThread = std::thread([&]() {
+            daemon::processConnection(
+                ref<Store>(store),
+                FdSource(toServer.readSide.get()),
+                FdSink(toClient.writeSide.get()),
+                Trusted,
+                daemon::Recursive);
+        });
+
+        conn.to = FdSink(toServer.writeSide.get());
+        conn.from = FdSource(toClient.readSide.get());
+        std::tie(conn.protoVersion, conn.features) = WorkerProto::BasicClientConnection::handshake(
+            conn.to, conn.from, PROTOCOL_VERSION, WorkerProto::allFeatures);
+        conn.postHandshake(*store);
+        conn.processStderr(nullptr);
+    }
+
+    void TearDown() override
+    {
+        conn.closeWrite();
+        daemonThread.join();
+        experimentalFeatureSettings.experimentalFeatures.assign(oldFeatures);
+    }
+
+    ValidPathInfo registerPath(std::string_view name, StorePathSet references = {})
+    {
+        ValidPathInfo info{StorePath::random(name), UnkeyedValidPathInfo(Hash(HashAlgorithm::SHA256))};
+        info.references = std::move(references);
+        store->registerValidPath(info);
+        return info;
+    }
+};
+
+TEST_F(WorkerProtoDaemonTest, queryPathInfos)
+{
+    ASSERT_TRUE(conn.features.count(WorkerProto::featureBatchedQueries));
+
+    auto a = registerPath("a");
+    auto b = registerPath("b", {a.path});
+    auto missing = StorePath::random("missing");
+
+    auto infos = conn.queryPathInfos(*store, nullptr, {a.path, b.path, missing});
+
+    ASSERT_EQ(infos.size(), 2);
+    std::map<StorePath, ValidPathInfo> byPath;
+    for (auto & info : infos)
+        byPath.insert_or_assign(info.path, info);
+    ASSERT_EQ(byPath.count(missing), 0);
+    ASSERT_EQ(byPath.at(a.path).references, StorePathSet{});
+    ASSERT_EQ(byPath.at(b.path).references, StorePathSet{a.path});
+    ASSERT_EQ(byPath.at(b.path).narHash, b.narHash);
+
+    ASSERT_EQ(conn.queryPathInfos(*store, nullptr, {}).size(), 0);
+}
+
+TEST_F(WorkerProtoDaemonTest, queryRealisations)
+{
+    ASSERT_TRUE(conn.features.count(WorkerProto::featureBatchedQueries));
+
+    auto out = registerPath("out");
+    Realisation realisation{
+        .id = {
+            .drvHash = hashString(HashAlgorithm::SHA256, "known"),
+            .outputName = "out",
+        },
+        .outPath = out.path,
+    };
+    store->registerDrvOutput(realisation);
+    DrvOutput unknown{
+        .drvHash = hashString(HashAlgorithm::SHA256, "unknown"),
+        .outputName = "out",
+    };
+
+    conn.to << WorkerProto::Op::QueryRealisations;
+    WorkerProto::write(*store, conn, std::set<DrvOutput>{realisation.id, unknown});
+    conn.processStderr(nullptr);
+    auto realisations = WorkerProto::Serialise<std::set<Realisation>>::read(*store, conn);
+
+    ASSERT_EQ(realisations.size(), 1);
+    ASSERT_EQ(realisations.begin()->id, realisation.id);
+    ASSERT_EQ(realisations.begin()->outPath, out.path);
+}
+
 }
@@ -103,6 +103,70 @@ std::optional<std::string> BinaryCacheStore::getFile(const std::string & path)
     return std::move(sink.s);
 }
 
+std::optional<std::string> BinaryCacheStore::getFileRange(const std::string & path, uint64_t offset, uint64_t length)
+{
+    return std::nullopt;
+}
+
+/* The size of the frames written with `seekable-compression`. */
+static const size_t seekableFrameSize = 1 << 20;
+
+std::shared_ptr<SourceAccessor> BinaryCacheStore::getSeekableNarAccessor(const StorePath & storePath)
+{
+    auto info = std::dynamic_pointer_cast<const NarInfo>(queryPathInfo(storePath).get_ptr());
+    if (!info || info->compression != "zstd" || info->fileSize < SeekTable::footerSize)
+        return nullptr;
+
+    auto footer = getFileRange(info->url, info->fileSize - SeekTable::footerSize, SeekTable::footerSize);
+    if (!footer) return nullptr;
+    auto tableSize = SeekTable::tableSize(*footer);
+    if (!tableSize || *tableSize > info->fileSize) return nullptr;
+
+    /* The listing gives the offsets of the files in the NAR. If it or
+       the seek table doesn't make sense, we can still fall back to
+       downloading the entire NAR. */
+    auto listing = getFile(std::string(storePath.hashPart()) + ".ls");
+    if (!listing) return nullptr;
+
+    try {
+        auto json = nlohmann::json::parse(*listing);
+        if (json.value("version", 0) != 1 || !json.contains("root")) return nullptr;
+
+        auto table = getFileRange(info->url, info->fileSize - *tableSize, *tableSize);
+        if (!table) return nullptr;
+        auto seekTable = std::make_shared<SeekTable>(SeekTable::parse(*table));
+        if (seekTable->frames.empty()
+            || seekTable->frames.back().compressedOffset + seekTable->frames.back().compressedSize != info->fileSize - *tableSize)
+            throw CompressionError("seek table does not match the size of '%s'", info->url);
+
+        auto self = std::dynamic_pointer_cast<BinaryCacheStore>(shared_from_this());
+
+        auto accessor = makeLazyNarAccessor(json["root"].dump(),
+            [self, url(info->url), seekTable](uint64_t offset, uint64_t length) -> std::string {
+                auto [first, last] = seekTable->findFrames(offset, length);
+                if (first == last) return "";
+                auto & firstFrame = seekTable->frames[first];
+                auto & lastFrame = seekTable->frames[last - 1];
+                auto compressed = self->getFileRange(url,
+                    firstFrame.compressedOffset,
+                    lastFrame.compressedOffset + lastFrame.compressedSize - firstFrame.compressedOffset);
+                if (!compressed)
+                    throw Error("cannot read part of '%s' from binary cache '%s'", url, self->getUri());
+                return decompress("zstd", *compressed).substr(offset - firstFrame.uncompressedOffset, length);
+            });
+
+        debug("reading NAR of '%s' using range requests", printStorePath(storePath));
+
+        return accessor;
+    } catch (nlohmann::json::exception & e) {
+        warn("ignoring malformed listing of '%s' in binary cache '%s': %s", printStorePath(storePath), getUri(), e.what());
+    } catch (CompressionError & e) {
+        warn("ignoring malformed seek table of '%s' in binary cache '%s': %s", printStorePath(storePath), getUri(), e.msg());
+    }
+
+    return nullptr;
+}
+
 std::string BinaryCacheStore::narInfoFileFor(const StorePath & storePath)
 {
     return std::string(storePath.hashPart()) + ".narinfo";
@@ -144,7 +208,9 @@ ref<const ValidPathInfo> BinaryCacheStore::addToStoreCommon(
     {
     FdSink fileSink(fdTemp.get());
     TeeSink teeSinkCompressed { fileSink, fileHashSink };
-    auto compressionSink = makeCompressionSink(compression, teeSinkCompressed, parallelCompression, compressionLevel);
+    auto compressionSink = seekableCompression && compression == "zstd"
+        ? makeSeekableCompressionSink(compression, teeSinkCompressed, seekableFrameSize, compressionLevel)
+        : makeCompressionSink(compression, teeSinkCompressed, parallelCompression, compressionLevel);
     TeeSink teeSinkUncompressed { *compressionSink, narHashSink };
     TeeSource teeSource { narSource, teeSinkUncompressed };
     narAccessor = makeNarAccessor(teeSource);
@@ -257,9 +323,14 @@ ref<const ValidPathInfo> BinaryCacheStore::addToStoreCommon(
     /* Atomically write the NAR file. */
     if (repair || !fileExists(narInfo->url)) {
         stats.narWrite++;
+        auto now3 = std::chrono::steady_clock::now();
         upsertFile(narInfo->url,
             std::make_shared<std::fstream>(fnTemp, std::ios_base::in | std::ios_base::binary),
             "application/x-nix-nar");
+        auto uploadDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - now3).count();
+        printMsg(lvlTalkative, "uploaded '%s' (%d bytes in %d ms) to binary cache",
+            narInfo->url, fileSize, uploadDuration);
+        stats.narWriteUploadTimeMs += uploadDuration;
     } else
         stats.narWriteAverted++;
 
@@ -23,6 +23,13 @@ struct BinaryCacheStoreConfig : virtual StoreConfig
     const Setting<bool> writeNARListing{this, false, "write-nar-listing",
         "Whether to write a JSON file that lists the files in each NAR."};
 
+    const Setting<bool> seekableCompression{this, false, "seekable-compression",
+        R"(
+          Whether to compress NARs as a sequence of independently compressed 1 MiB frames followed by a seek table.
+          This is currently only available for `zstd`, and the result is still a regular `.nar.zst` file.
+          Together with `write-nar-listing`, it allows commands such as `nix store cat` to fetch individual files from the cache using range requests instead of downloading the entire NAR.
+        )"};
+
     const Setting<bool> writeDebugInfo{this, false, "index-debug-info",
         R"(
           Whether to index DWARF debug info files by build ID. This allows [`dwarffs`](https://github.com/edolstra/dwarffs) to
@@ -94,6 +101,21 @@ public:
 
     std::optional<std::string> getFile(const std::string & path);
 
+    /**
+     * Return `length` bytes at `offset` of the specified file, or
+     * `std::nullopt` if this store doesn't support reading part of a
+     * file.
+     */
+    virtual std::optional<std::string> getFileRange(const std::string & path, uint64_t offset, uint64_t length);
+
+    /**
+     * Return an accessor for the NAR of `storePath` that only fetches
+     * the parts of the NAR that are read, or `nullptr` if the NAR
+     * wasn't written with `seekable-compression` and
+     * `write-nar-listing`, or this store doesn't support range reads.
+     */
+    std::shared_ptr<SourceAccessor> getSeekableNarAccessor(const StorePath & storePath);
+
 public:
 
     virtual void init() override;
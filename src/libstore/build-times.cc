@@ -0,0 +1,135 @@
+#include "build-times.hh"
+#include "names.hh"
+#include "users.hh"
+#include "sync.hh"
+#include "sqlite.hh"
+#include "file-system.hh"
+#include "globals.hh"
+#include "logging.hh"
+
+#include <unistd.h>
+
+namespace nix {
+
+static const char * schema = R"sql(
+
+create table if not exists BuildTimes (
+    system    text not null,
+    name      text not null,
+    duration  integer not null, -- in seconds
+    nrBuilds  integer not null,
+    timestamp integer not null,
+    primary key (system, name)
+);
+
+)sql";
+
+class BuildTimesImpl : public BuildTimes
+{
+    struct State
+    {
+        SQLite db;
+        SQLiteStmt query, upsert;
+        bool open = false, writable = false;
+    };
+
+    Sync<State> _state;
+
+public:
+
+    /* Builds are recorded by whoever runs them, which is usually the
+       daemon, while `nix build --print-schedule` runs as the client.
+       So keep the build times in the state directory, and let users
+       who cannot write to it read them. */
+    BuildTimesImpl(Path dbPath = settings.nixStateDir + "/build-times-v1.sqlite")
+    {
+        auto state(_state.lock());
+
+        try {
+            if (!pathExists(dbPath) || access(dbPath.c_str(), W_OK) == 0) {
+                createDirs(dirOf(dbPath));
+
+                state->db = SQLite(dbPath);
+
+                state->db.isCache();
+
+                state->db.exec(schema);
+
+                state->upsert.create(state->db,
+                    "insert or replace into BuildTimes(system, name, duration, nrBuilds, timestamp) values (?, ?, ?, ?, ?)");
+
+                state->writable = true;
+            } else
+                state->db = SQLite(dbPath, SQLiteOpenMode::ReadOnly);
+
+            state->query.create(state->db,
+                "select duration, nrBuilds from BuildTimes where system = ? and name = ?");
+
+            state->open = true;
+        } catch (Error & e) {
+            debug("not using build times from '%s': %s", dbPath, e.msg());
+        }
+    }
+
+    std::optional<std::pair<std::chrono::seconds, uint64_t>> query(
+        State & state, std::string_view system, std::string_view drvName)
+    {
+        auto query(state.query.use()(system)(DrvName(drvName).name));
+        if (!query.next()) return std::nullopt;
+        return std::pair{std::chrono::seconds(query.getInt(0)), (uint64_t) query.getInt(1)};
+    }
+
+    std::optional<std::chrono::seconds> lookup(
+        std::string_view system, std::string_view drvName) override
+    {
+        return retrySQLite<std::optional<std::chrono::seconds>>([&]() -> std::optional<std::chrono::seconds> {
+            auto state(_state.lock());
+            if (!state->open) return std::nullopt;
+            if (auto res = query(*state, system, drvName))
+                return res->first;
+            return std::nullopt;
+        });
+    }
+
+    void record(
+        std::string_view system, std::string_view drvName, std::chrono::seconds duration) override
+    {
+        retrySQLite<void>([&]() {
+            auto state(_state.lock());
+            if (!state->writable) return;
+            SQLiteTxn txn(state->db);
+
+            /* Weigh the new duration like the last few builds
+               together, so that a single outlier doesn't throw off
+               the estimate. */
+            auto prev = query(*state, system, drvName);
+            auto nrBuilds = prev ? prev->second + 1 : 1;
+            auto estimate = prev
+                ? prev->first + (duration - prev->first) / (int64_t) std::min<uint64_t>(nrBuilds, 4)
+                : duration;
+
+            state->upsert.use()
+                (system)
+                (DrvName(drvName).name)
+                (estimate.count())
+                ((int64_t) nrBuilds)
+                (time(0))
+                .exec();
+
+            txn.commit();
+        });
+    }
+};
+
+ref<BuildTimes> getBuildTimes()
+{
+    static ref<BuildTimes> cache = make_ref<BuildTimesImpl>();
+    return cache;
+}
+
+ref<BuildTimes> getTestBuildTimes(Path dbPath)
+{
+    return make_ref<BuildTimesImpl>(dbPath);
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+///@file
+
+#include "ref.hh"
+#include "types.hh"
+
+#include <chrono>
+#include <optional>
+
+namespace nix {
+
+/**
+ * A cache of how long derivations took to build, used to estimate
+ * how long future builds will take. Durations are keyed by the
+ * derivation's system and its name without the version (see
+ * `DrvName`), so they carry over to new versions of a package.
+ *
+ * The durations are kept in the Nix state directory rather than in
+ * the user's cache, so that clients of the daemon see the builds it
+ * performed.
+ */
+class BuildTimes
+{
+public:
+
+    virtual ~BuildTimes() { }
+
+    /**
+     * Return the estimated build time of a derivation, if it (or
+     * another version of it) was built before.
+     */
+    virtual std::optional<std::chrono::seconds> lookup(
+        std::string_view system, std::string_view drvName) = 0;
+
+    /**
+     * Record that a derivation took `duration` to build. This is
+     * averaged with the previous builds.
+     */
+    virtual void record(
+        std::string_view system, std::string_view drvName, std::chrono::seconds duration) = 0;
+};
+
+ref<BuildTimes> getBuildTimes();
+
+ref<BuildTimes> getTestBuildTimes(Path dbPath);
+
+}
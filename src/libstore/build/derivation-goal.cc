@@ -17,6 +17,8 @@
 #include "topo-sort.hh"
 #include "callback.hh"
 #include "local-store.hh" // TODO remove, along with remaining downcasts
+#include "build-times.hh"
+#include "schedule.hh"
 
 #include <regex>
 #include <queue>
@@ -181,6 +183,7 @@ Goal::Co DerivationGoal::loadDerivation()
     for (auto * drvStore : { &worker.evalStore, &worker.store }) {
         if (drvStore->isValidPath(drvPath)) {
             drv = std::make_unique<Derivation>(drvStore->readDerivation(drvPath));
+            invalidateCriticalPathLength();
             break;
         }
     }
@@ -930,6 +933,15 @@ void runPostBuildHook(
     });
 }
 
+std::chrono::seconds DerivationGoal::estimatedDuration()
+{
+    /* Until the derivation is loaded, assume it's an average one. */
+    if (!drv) return defaultBuildTime;
+    if (!estimatedDuration_)
+        estimatedDuration_ = estimateBuildTime(*drv);
+    return *estimatedDuration_;
+}
+
 Goal::Co DerivationGoal::buildDone()
 {
     trace("build done");
@@ -1028,6 +1040,17 @@ Goal::Co DerivationGoal::buildDone()
         outputLocks.setDeletion(true);
         outputLocks.unlock();
 
+        /* Remember how long this took, to prioritise future builds of
+           this package. */
+        if (buildMode == bmNormal && buildResult.startTime && buildResult.stopTime >= buildResult.startTime) {
+            try {
+                getBuildTimes()->record(drv->platform, drv->name,
+                    std::chrono::seconds(buildResult.stopTime - buildResult.startTime));
+            } catch (...) {
+                ignoreExceptionExceptInterrupt();
+            }
+        }
+
         co_return done(BuildResult::Built, std::move(builtOutputs));
 
     } catch (BuildError & e) {
@@ -341,6 +341,15 @@ struct DerivationGoal : public Goal
     JobCategory jobCategory() const override {
         return JobCategory::Build;
     };
+
+    std::chrono::seconds estimatedDuration() override;
+
+private:
+
+    /**
+     * Cached result of `estimatedDuration()`, once `drv` is known.
+     */
+    std::optional<std::chrono::seconds> estimatedDuration_;
 };
 
 MakeError(NotDeterministic, BuildError);
@@ -137,6 +137,31 @@ void Goal::addWaitee(GoalPtr waitee)
 {
     waitees.insert(waitee);
     addToWeakGoals(waitee->waiters, shared_from_this());
+    waitee->invalidateCriticalPathLength();
+}
+
+
+std::chrono::seconds Goal::criticalPathLength()
+{
+    if (!criticalPathLength_) {
+        std::chrono::seconds longest{0};
+        for (auto & i : waiters)
+            if (auto waiter = i.lock())
+                longest = std::max(longest, waiter->criticalPathLength());
+        criticalPathLength_ = estimatedDuration() + longest;
+    }
+    return *criticalPathLength_;
+}
+
+
+void Goal::invalidateCriticalPathLength()
+{
+    /* A goal's length is only cached if those of its waiters are, so
+       we can stop at goals that have nothing cached. */
+    if (!criticalPathLength_) return;
+    criticalPathLength_.reset();
+    for (auto & waitee : waitees)
+        waitee->invalidateCriticalPathLength();
 }
 
 
@@ -159,6 +184,7 @@ void Goal::waiteeDone(GoalPtr waitee, ExitCode result)
            remaining waitees. */
         for (auto & goal : waitees) {
             goal->waiters.extract(shared_from_this());
+            goal->invalidateCriticalPathLength();
         }
         waitees.clear();
 
@@ -186,6 +212,7 @@ Goal::Done Goal::amDone(ExitCode result, std::optional<Error> ex)
         if (goal) goal->waiteeDone(shared_from_this(), result);
     }
     waiters.clear();
+    invalidateCriticalPathLength();
     worker.removeGoal(shared_from_this());
 
     cleanup();
@@ -429,6 +429,33 @@ public:
      * @see JobCategory
      */
     virtual JobCategory jobCategory() const = 0;
+
+    /**
+     * Hint for the scheduler: the expected duration of this goal's
+     * own work, not counting the goals it waits for.
+     */
+    virtual std::chrono::seconds estimatedDuration()
+    {
+        return std::chrono::seconds(0);
+    }
+
+    /**
+     * The expected time until this goal and all goals that
+     * (transitively) wait for it are done, if there were unlimited
+     * build slots. This is cached until it is invalidated.
+     */
+    std::chrono::seconds criticalPathLength();
+
+    /**
+     * Forget the cached critical path length of this goal, and of
+     * the goals it waits for since theirs include it. Must be called
+     * when `waiters` or `estimatedDuration()` changes.
+     */
+    void invalidateCriticalPathLength();
+
+private:
+
+    std::optional<std::chrono::seconds> criticalPathLength_;
 };
 
 void addToWeakGoals(WeakGoals & goals, GoalPtr p);
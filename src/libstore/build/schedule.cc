@@ -0,0 +1,122 @@
+#include "schedule.hh"
+#include "build-times.hh"
+#include "derivations.hh"
+
+#include <queue>
+
+namespace nix {
+
+std::chrono::seconds estimateBuildTime(const BasicDerivation & drv)
+{
+    try {
+        if (auto duration = getBuildTimes()->lookup(drv.platform, drv.name))
+            return *duration;
+    } catch (...) {
+        ignoreExceptionExceptInterrupt();
+    }
+    return defaultBuildTime;
+}
+
+std::map<StorePath, std::chrono::seconds> criticalPathLengths(
+    const std::map<StorePath, ScheduleNode> & nodes)
+{
+    std::map<StorePath, StorePathSet> dependents;
+    for (auto & [path, node] : nodes)
+        for (auto & input : node.inputs)
+            if (nodes.count(input))
+                dependents[input].insert(path);
+
+    std::map<StorePath, std::chrono::seconds> res;
+
+    std::function<std::chrono::seconds(const StorePath &)> visit;
+    visit = [&](const StorePath & path) {
+        auto i = res.find(path);
+        if (i != res.end()) return i->second;
+        std::chrono::seconds longest{0};
+        for (auto & dependent : dependents[path])
+            longest = std::max(longest, visit(dependent));
+        auto length = nodes.at(path).duration + longest;
+        res.insert_or_assign(path, length);
+        return length;
+    };
+
+    for (auto & [path, _] : nodes)
+        visit(path);
+
+    return res;
+}
+
+Schedule simulateSchedule(const std::map<StorePath, ScheduleNode> & nodes, size_t jobs)
+{
+    auto lengths = criticalPathLengths(nodes);
+
+    std::map<StorePath, StorePathSet> dependents;
+    std::map<StorePath, size_t> nrInputs;
+    for (auto & [path, node] : nodes) {
+        nrInputs[path] = 0;
+        for (auto & input : node.inputs)
+            if (nodes.count(input)) {
+                dependents[input].insert(path);
+                nrInputs[path]++;
+            }
+    }
+
+    /* Ready nodes, longest critical path first. */
+    auto compareReady = [&](const StorePath & a, const StorePath & b) {
+        auto la = lengths.at(a), lb = lengths.at(b);
+        return la != lb ? la > lb : a < b;
+    };
+    std::set<StorePath, decltype(compareReady)> ready(compareReady);
+
+    for (auto & [path, n] : nrInputs)
+        if (n == 0) ready.insert(path);
+
+    using Running = std::pair<std::chrono::seconds, StorePath>;
+    std::priority_queue<Running, std::vector<Running>, std::greater<Running>> running;
+
+    Schedule schedule;
+    std::chrono::seconds now{0};
+
+    jobs = std::max<size_t>(jobs, 1);
+
+    while (true) {
+        while (!ready.empty() && running.size() < jobs) {
+            auto path = *ready.begin();
+            ready.erase(ready.begin());
+            auto end = now + nodes.at(path).duration;
+            schedule.entries.push_back({.drvPath = path, .start = now, .end = end});
+            running.push({end, path});
+        }
+
+        if (running.empty()) break;
+
+        auto [end, path] = running.top();
+        running.pop();
+        now = end;
+        schedule.makespan = std::max(schedule.makespan, end);
+
+        for (auto & dependent : dependents[path])
+            if (--nrInputs.at(dependent) == 0)
+                ready.insert(dependent);
+    }
+
+    return schedule;
+}
+
+Schedule computeSchedule(Store & store, const StorePathSet & drvPaths, size_t jobs)
+{
+    std::map<StorePath, ScheduleNode> nodes;
+
+    for (auto & drvPath : drvPaths) {
+        auto drv = store.readDerivation(drvPath);
+        ScheduleNode node{.duration = estimateBuildTime(drv)};
+        for (auto & [inputDrv, _] : drv.inputDrvs.map)
+            if (drvPaths.count(inputDrv))
+                node.inputs.insert(inputDrv);
+        nodes.insert_or_assign(drvPath, std::move(node));
+    }
+
+    return simulateSchedule(nodes, jobs);
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+///@file
+
+#include "store-api.hh"
+
+#include <chrono>
+
+namespace nix {
+
+struct BasicDerivation;
+
+/**
+ * The assumed build time of derivations that haven't been built
+ * before.
+ */
+constexpr std::chrono::seconds defaultBuildTime{60};
+
+/**
+ * Estimate how long `drv` takes to build from previous builds of the
+ * same package (see `BuildTimes`).
+ */
+std::chrono::seconds estimateBuildTime(const BasicDerivation & drv);
+
+/**
+ * A derivation to be scheduled, with its estimated build time and
+ * the derivations among those being scheduled that it depends on.
+ */
+struct ScheduleNode
+{
+    std::chrono::seconds duration;
+    StorePathSet inputs;
+};
+
+/**
+ * Return the length of the critical path starting at every node,
+ * i.e. the time it takes to build that node and everything that
+ * depends on it, if there were unlimited build slots. Nodes with
+ * longer critical paths should be started first.
+ */
+std::map<StorePath, std::chrono::seconds> criticalPathLengths(
+    const std::map<StorePath, ScheduleNode> & nodes);
+
+struct Schedule
+{
+    struct Entry
+    {
+        StorePath drvPath;
+        std::chrono::seconds start, end;
+    };
+
+    /**
+     * The builds, sorted by start time.
+     */
+    std::vector<Entry> entries;
+
+    /**
+     * The expected time until all builds have finished.
+     */
+    std::chrono::seconds makespan{0};
+};
+
+/**
+ * Simulate building `nodes` with `jobs` build slots, starting the
+ * ready node with the longest critical path whenever a slot is free.
+ * This is how the `Worker` prioritises builds.
+ */
+Schedule simulateSchedule(const std::map<StorePath, ScheduleNode> & nodes, size_t jobs);
+
+/**
+ * Compute the expected schedule of building the derivations
+ * `drvPaths` (e.g. the `willBuild` set returned by
+ * `Store::queryMissing()`) with `jobs` build slots.
+ */
+Schedule computeSchedule(Store & store, const StorePathSet & drvPaths, size_t jobs);
+
+}
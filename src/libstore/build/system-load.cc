@@ -0,0 +1,149 @@
+#include "system-load.hh"
+#include "file-system.hh"
+#include "strings.hh"
+#include "util.hh"
+
+#if __linux__
+# include "cgroup.hh"
+#endif
+
+#include <cstdlib>
+
+namespace nix {
+
+std::optional<double> parsePressure(std::string_view s)
+{
+    for (auto & line : tokenizeString<std::vector<std::string>>(s, "\n")) {
+        auto fields = tokenizeString<std::vector<std::string>>(line, " ");
+        if (fields.empty() || fields[0] != "some") continue;
+        for (auto & field : fields)
+            if (hasPrefix(field, "avg10="))
+                return string2Float<double>(field.substr(6));
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> parseMemAvailable(std::string_view s)
+{
+    for (auto & line : tokenizeString<std::vector<std::string>>(s, "\n")) {
+        auto fields = tokenizeString<std::vector<std::string>>(line, " ");
+        if (fields.size() == 3 && fields[0] == "MemAvailable:" && fields[2] == "kB")
+            if (auto kb = string2Int<uint64_t>(fields[1]))
+                return *kb * 1024;
+    }
+    return std::nullopt;
+}
+
+#if __linux__
+static std::optional<double> readPressure(const Path & path)
+{
+    try {
+        return parsePressure(readFile(path));
+    } catch (SysError &) {
+        /* The kernel doesn't support PSI, or the cgroup is gone. */
+        return std::nullopt;
+    }
+}
+
+static void maxPressure(std::optional<double> & res, std::optional<double> pressure)
+{
+    if (pressure && (!res || *pressure > *res))
+        res = pressure;
+}
+#endif
+
+SystemLoad getSystemLoad(const std::optional<Path> & buildCgroups)
+{
+    SystemLoad load;
+
+#ifndef _WIN32
+    double loadAverage;
+    if (getloadavg(&loadAverage, 1) == 1)
+        load.loadAverage = loadAverage;
+#endif
+
+#if __linux__
+    try {
+        load.availableMemory = parseMemAvailable(readFile(Path("/proc/meminfo")));
+    } catch (SysError &) {
+    }
+
+    if (buildCgroups) {
+        try {
+            for (auto & entry : std::filesystem::directory_iterator{*buildCgroups}) {
+                if (!entry.is_directory() || !hasPrefix(entry.path().filename().string(), "nix-build-"))
+                    continue;
+                maxPressure(load.cpuPressure, readPressure(entry.path() / "cpu.pressure"));
+                maxPressure(load.memoryPressure, readPressure(entry.path() / "memory.pressure"));
+            }
+        } catch (std::filesystem::filesystem_error &) {
+        }
+    } else {
+        load.cpuPressure = readPressure(Path("/proc/pressure/cpu"));
+        load.memoryPressure = readPressure(Path("/proc/pressure/memory"));
+    }
+#endif
+
+    return load;
+}
+
+std::optional<std::string> checkBuildAdmission(
+    const SystemLoad & load,
+    unsigned int maxLoad,
+    uint64_t minFreeMemory,
+    unsigned int maxPressure)
+{
+    if (maxLoad && load.loadAverage && *load.loadAverage > maxLoad)
+        return fmt("load average %.2f exceeds 'max-load' (%d)", *load.loadAverage, maxLoad);
+
+    if (minFreeMemory && load.availableMemory && *load.availableMemory < minFreeMemory)
+        return fmt("available memory %d MiB is below 'min-free-memory' (%d MiB)",
+            *load.availableMemory / (1024 * 1024), minFreeMemory / (1024 * 1024));
+
+    if (maxPressure && load.cpuPressure && *load.cpuPressure > maxPressure)
+        return fmt("CPU pressure %.2f%% exceeds 'max-pressure' (%d%%)", *load.cpuPressure, maxPressure);
+
+    if (maxPressure && load.memoryPressure && *load.memoryPressure > maxPressure)
+        return fmt("memory pressure %.2f%% exceeds 'max-pressure' (%d%%)", *load.memoryPressure, maxPressure);
+
+    return std::nullopt;
+}
+
+unsigned int adaptBuildCores(unsigned int cores, unsigned int nrCpus, std::optional<double> loadAverage)
+{
+    if (!loadAverage || *loadAverage <= nrCpus) return cores;
+    /* `0` means all CPUs. */
+    if (cores == 0) cores = nrCpus;
+    return std::max(1U, (unsigned int) (cores * nrCpus / *loadAverage));
+}
+
+const SystemLoad & BuildAdmission::currentLoad(Clock::time_point now)
+{
+    if (measuredAt == Clock::time_point::min() || measuredAt + interval <= now) {
+        load = measure();
+        measuredAt = now;
+        startedSinceMeasurement = false;
+    }
+    return load;
+}
+
+std::optional<std::string> BuildAdmission::check(
+    size_t nrRunning,
+    unsigned int maxLoad,
+    uint64_t minFreeMemory,
+    unsigned int maxPressure,
+    Clock::time_point now)
+{
+    if (!nrRunning || !(maxLoad || minFreeMemory || maxPressure))
+        return std::nullopt;
+
+    if (auto refusal = checkBuildAdmission(currentLoad(now), maxLoad, minFreeMemory, maxPressure))
+        return refusal;
+
+    if (startedSinceMeasurement)
+        return "a build was started since the system load was last measured";
+
+    return std::nullopt;
+}
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+///@file
+
+#include "types.hh"
+
+#include <chrono>
+#include <functional>
+#include <optional>
+
+namespace nix {
+
+/**
+ * A snapshot of how busy the system is, used to decide whether to
+ * start more local builds. Fields are empty if they are not
+ * supported on this platform.
+ */
+struct SystemLoad
+{
+    /**
+     * The 1-minute load average.
+     */
+    std::optional<double> loadAverage;
+
+    /**
+     * The memory available for starting new processes, in bytes.
+     */
+    std::optional<uint64_t> availableMemory;
+
+    /**
+     * The percentage of the last 10 seconds in which some tasks were
+     * stalled waiting for CPU or memory, respectively.
+     */
+    std::optional<double> cpuPressure, memoryPressure;
+};
+
+/**
+ * Measure the current system load. If `buildCgroups` is set, the
+ * pressure is the highest of those of the cgroups in that directory
+ * that belong to builds.
+ */
+SystemLoad getSystemLoad(const std::optional<Path> & buildCgroups = std::nullopt);
+
+/**
+ * Parse the `avg10` value of the `some` line of a PSI file such as
+ * `/proc/pressure/memory`.
+ */
+std::optional<double> parsePressure(std::string_view s);
+
+/**
+ * Parse the `MemAvailable` value of `/proc/meminfo`.
+ */
+std::optional<uint64_t> parseMemAvailable(std::string_view s);
+
+/**
+ * Return why a new build should not be started under `load`, or
+ * `std::nullopt` if it can be started. Limits that are zero are
+ * ignored.
+ */
+std::optional<std::string> checkBuildAdmission(
+    const SystemLoad & load,
+    unsigned int maxLoad,
+    uint64_t minFreeMemory,
+    unsigned int maxPressure);
+
+/**
+ * Scale down `cores` when the load average exceeds the number of
+ * CPUs, so that a new build doesn't oversubscribe the machine
+ * further.
+ */
+unsigned int adaptBuildCores(unsigned int cores, unsigned int nrCpus, std::optional<double> loadAverage);
+
+/**
+ * Decides whether to start more local builds based on the system
+ * load. A build only shows up in the measurements some time after it
+ * has started, so while other builds are running, at most one new
+ * build is admitted per measurement.
+ */
+class BuildAdmission
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::function<SystemLoad()> measure;
+    Clock::duration interval;
+
+    SystemLoad load;
+    Clock::time_point measuredAt = Clock::time_point::min();
+    bool startedSinceMeasurement = false;
+
+public:
+
+    /**
+     * @param measure Takes a new measurement of the system load.
+     * @param interval How long a measurement is used for.
+     */
+    BuildAdmission(std::function<SystemLoad()> measure, Clock::duration interval)
+        : measure(std::move(measure))
+        , interval(interval)
+    { }
+
+    /**
+     * Return the last measurement of the system load, measuring again
+     * if it is older than the interval.
+     */
+    const SystemLoad & currentLoad(Clock::time_point now = Clock::now());
+
+    /**
+     * Return why a new build should not be started while `nrRunning`
+     * local builds are running, or `std::nullopt` if it can be
+     * started. A build is always admitted if none are running.
+     */
+    std::optional<std::string> check(
+        size_t nrRunning,
+        unsigned int maxLoad,
+        uint64_t minFreeMemory,
+        unsigned int maxPressure,
+        Clock::time_point now = Clock::now());
+
+    /**
+     * Record that a local build was started.
+     */
+    void buildStarted()
+    {
+        startedSinceMeasurement = true;
+    }
+};
+
+}
@@ -9,11 +9,17 @@
 #  include "hook-instance.hh"
 #endif
 #include "signals.hh"
+#if __linux__
+#  include "cgroup.hh"
+#endif
+
+#include <algorithm>
 
 namespace nix {
 
 Worker::Worker(Store & store, Store & evalStore)
-    : act(*logger, actRealise)
+    : buildAdmission([this]() { return measureSystemLoad(); }, std::chrono::seconds(1))
+    , act(*logger, actRealise)
     , actDerivations(*logger, actBuilds)
     , actSubstitutions(*logger, actCopyPaths)
     , store(store)
@@ -196,6 +202,52 @@ size_t Worker::getNrSubstitutions()
 }
 
 
+SystemLoad Worker::measureSystemLoad()
+{
+    std::optional<Path> buildCgroups;
+#if __linux__
+    if (settings.useCgroups)
+        if (auto cgroupFS = getCgroupFS())
+            buildCgroups = canonPath(*cgroupFS + "/" + getRootCgroup());
+#endif
+    return getSystemLoad(buildCgroups);
+}
+
+
+bool Worker::canStartLocalBuild()
+{
+    if (getNrLocalBuilds() >= settings.maxBuildJobs) return false;
+
+    /* Always allow one build, otherwise we might never make
+       progress. */
+    auto refusal = buildAdmission.check(
+        getNrLocalBuilds(), settings.maxLoad, settings.minFreeMemory, settings.maxPressure);
+
+    if (refusal != lastBuildRefusal) {
+        if (refusal)
+            printMsg(lvlTalkative, "postponing new local builds (%d running): %s", getNrLocalBuilds(), *refusal);
+        else
+            printMsg(lvlTalkative, "starting new local builds again (%d running)", getNrLocalBuilds());
+        lastBuildRefusal = refusal;
+    }
+
+    return !refusal;
+}
+
+
+unsigned int Worker::getBuildCores()
+{
+    if (!settings.maxLoad) return settings.buildCores;
+
+    auto & load = buildAdmission.currentLoad();
+    auto cores = adaptBuildCores(settings.buildCores, settings.getDefaultCores(), load.loadAverage);
+    if (cores != settings.buildCores)
+        printMsg(lvlTalkative, "the system is oversubscribed (load average %.2f), using %d cores for the new build",
+            *load.loadAverage, cores);
+    return cores;
+}
+
+
 void Worker::childStarted(GoalPtr goal, const std::set<MuxablePipePollState::CommChannel> & channels,
     bool inBuildSlot, bool respectTimeouts)
 {
@@ -214,6 +266,7 @@ void Worker::childStarted(GoalPtr goal, const std::set<MuxablePipePollState::Com
             break;
         case JobCategory::Build:
             nrLocalBuilds++;
+            buildAdmission.buildStarted();
             break;
         default:
             unreachable();
@@ -262,9 +315,14 @@ void Worker::waitForBuildSlot(GoalPtr goal)
 {
     goal->trace("wait for build slot");
     bool isSubstitutionGoal = goal->jobCategory() == JobCategory::Substitution;
-    if ((!isSubstitutionGoal && getNrLocalBuilds() < settings.maxBuildJobs) ||
+    if ((!isSubstitutionGoal && canStartLocalBuild()) ||
         (isSubstitutionGoal && getNrSubstitutions() < settings.maxSubstitutionJobs))
         wakeUp(goal); /* we can do it right away */
+    else if (!isSubstitutionGoal && getNrLocalBuilds() < settings.maxBuildJobs)
+        /* There is a free slot, but the system is too busy. Check
+           again later, since the load may drop without any of our
+           builds finishing. */
+        waitForAWhile(goal);
     else
         addToWeakGoals(wantingToBuild, goal);
 }
@@ -316,8 +374,8 @@ void Worker::run(const Goals & _topGoals)
         if (auto localStore = dynamic_cast<LocalStore *>(&store))
             localStore->autoGC(false);
 
-        /* Call every wake goal (in the ordering established by
-           CompareGoalPtrs). */
+        /* Call every wake goal, those on the longest critical path
+           first so that they get the free build slots. */
         while (!awake.empty() && !topGoals.empty()) {
             Goals awake2;
             for (auto & i : awake) {
@@ -325,7 +383,11 @@ void Worker::run(const Goals & _topGoals)
                 if (goal) awake2.insert(goal);
             }
             awake.clear();
-            for (auto & goal : awake2) {
+            std::vector<GoalPtr> awake3(awake2.begin(), awake2.end());
+            std::stable_sort(awake3.begin(), awake3.end(), [&](const GoalPtr & a, const GoalPtr & b) {
+                return a->criticalPathLength() > b->criticalPathLength();
+            });
+            for (auto & goal : awake3) {
                 checkInterrupt();
                 goal->work();
                 if (topGoals.empty()) break; // stuff may have been cancelled
@@ -6,6 +6,7 @@
 #include "goal.hh"
 #include "realisation.hh"
 #include "muxable-pipe.hh"
+#include "system-load.hh"
 
 #include <future>
 #include <thread>
@@ -127,6 +128,19 @@ private:
      */
     std::map<StorePath, bool> pathContentsGoodCache;
 
+    /**
+     * Admission control for new local builds.
+     */
+    BuildAdmission buildAdmission;
+
+    /**
+     * Why new local builds were last postponed, so that only changes
+     * are logged.
+     */
+    std::optional<std::string> lastBuildRefusal;
+
+    SystemLoad measureSystemLoad();
+
 public:
 
     const Activity act;
@@ -242,6 +256,20 @@ public:
      */
     size_t getNrSubstitutions();
 
+    /**
+     * Whether a new local build can start now. This requires a free
+     * build slot and, unless no local build is running, that the
+     * system isn't too busy according to the `max-load`,
+     * `min-free-memory` and `max-pressure` settings (see
+     * `BuildAdmission`).
+     */
+    bool canStartLocalBuild();
+
+    /**
+     * Return the value of `NIX_BUILD_CORES` for a new local build.
+     */
+    unsigned int getBuildCores();
+
     /**
      * Registers a running child process.  `inBuildSlot` means that
      * the process counts towards the jobs limit.
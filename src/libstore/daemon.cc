@@ -729,10 +729,11 @@ static void performOp(TunnelLogger * logger, ref<Store> store,
         options.action = (GCOptions::GCAction) readInt(conn.from);
         options.pathsToDelete = WorkerProto::Serialise<StorePathSet>::read(*store, rconn);
         conn.from >> options.ignoreLiveness >> options.maxFreed;
+        /* Older clients send 0 here. */
+        options.incremental = readInt(conn.from);
         // obsolete fields
         readInt(conn.from);
         readInt(conn.from);
-        readInt(conn.from);
 
         GCResults results;
 
@@ -855,6 +856,17 @@ static void performOp(TunnelLogger * logger, ref<Store> store,
         break;
     }
 
+    case WorkerProto::Op::QueryPathInfos: {
+        auto paths = WorkerProto::Serialise<StorePathSet>::read(*store, rconn);
+        logger->startWork();
+        std::vector<ValidPathInfo> infos;
+        for (auto & [path, info] : store->queryPathInfos(paths))
+            if (info) infos.push_back(*info);
+        logger->stopWork();
+        WorkerProto::write(*store, wconn, infos);
+        break;
+    }
+
     case WorkerProto::Op::OptimiseStore:
         logger->startWork();
         store->optimiseStore();
@@ -990,6 +1002,17 @@ static void performOp(TunnelLogger * logger, ref<Store> store,
         break;
     }
 
+    case WorkerProto::Op::QueryRealisations: {
+        auto ids = WorkerProto::Serialise<std::set<DrvOutput>>::read(*store, rconn);
+        logger->startWork();
+        std::set<Realisation> realisations;
+        for (auto & [id, realisation] : store->queryRealisations(ids))
+            if (realisation) realisations.insert(*realisation);
+        logger->stopWork();
+        WorkerProto::write(*store, wconn, realisations);
+        break;
+    }
+
     case WorkerProto::Op::AddBuildLog: {
         StorePath path{readString(conn.from)};
         logger->startWork();
@@ -94,7 +94,7 @@ struct curlFileTransfer : public FileTransfer
             : fileTransfer(fileTransfer)
             , request(request)
             , act(*logger, lvlTalkative, actFileTransfer,
-                fmt(request.data ? "uploading '%s'" : "downloading '%s'", request.uri),
+                fmt(request.isUpload() ? "uploading '%s'" : "downloading '%s'", request.uri),
                 {request.uri}, request.parentAct)
             , callback(std::move(callback))
             , finalSink([this](std::string_view data) {
@@ -286,6 +286,12 @@ struct curlFileTransfer : public FileTransfer
         size_t readOffset = 0;
         size_t readCallback(char *buffer, size_t size, size_t nitems)
         {
+            if (request.dataStream) {
+                request.dataStream->read(buffer, size * nitems);
+                if (request.dataStream->bad())
+                    return CURL_READFUNC_ABORT;
+                return request.dataStream->gcount();
+            }
             if (readOffset == request.data->length())
                 return 0;
             auto count = std::min(size * nitems, request.data->length() - readOffset);
@@ -344,11 +350,24 @@ struct curlFileTransfer : public FileTransfer
             if (request.head)
                 curl_easy_setopt(req, CURLOPT_NOBODY, 1);
 
-            if (request.data) {
+            if (request.isUpload()) {
+                curl_off_t size;
+                readOffset = 0;
+                if (request.dataStream) {
+                    /* Rewind, in case this is a retry. */
+                    request.dataStream->clear();
+                    request.dataStream->seekg(0, std::ios_base::end);
+                    size = request.dataStream->tellg();
+                    request.dataStream->seekg(0);
+                    /* -1 means unknown, which makes curl use a chunked
+                       upload. */
+                    if (!*request.dataStream) size = -1;
+                } else
+                    size = request.data->length();
                 curl_easy_setopt(req, CURLOPT_UPLOAD, 1L);
                 curl_easy_setopt(req, CURLOPT_READFUNCTION, readCallbackWrapper);
                 curl_easy_setopt(req, CURLOPT_READDATA, this);
-                curl_easy_setopt(req, CURLOPT_INFILESIZE_LARGE, (curl_off_t) request.data->length());
+                curl_easy_setopt(req, CURLOPT_INFILESIZE_LARGE, size);
             }
 
             if (request.verifyTLS) {
@@ -410,6 +429,7 @@ struct curlFileTransfer : public FileTransfer
 
             else if (code == CURLE_OK && successfulStatuses.count(httpStatus))
             {
+                result.httpStatus = httpStatus;
                 result.cached = httpStatus == 304;
 
                 // In 2021, GitHub responds to If-None-Match with 304,
@@ -710,7 +730,7 @@ struct curlFileTransfer : public FileTransfer
 
     void enqueueItem(std::shared_ptr<TransferItem> item)
     {
-        if (item->request.data
+        if (item->request.isUpload()
             && !hasPrefix(item->request.uri, "http://")
             && !hasPrefix(item->request.uri, "https://"))
             throw nix::Error("uploading to '%s' is not supported", item->request.uri);
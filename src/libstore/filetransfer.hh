@@ -69,15 +69,27 @@ struct FileTransferRequest
     ActivityId parentAct;
     bool decompress = true;
     std::optional<std::string> data;
+    /**
+     * Alternatively to `data`, a stream from which the body of an
+     * upload is read while it is being sent, so that large uploads
+     * don't have to be held in memory. It must be seekable, so that
+     * the size can be determined and the upload can be retried.
+     */
+    std::shared_ptr<std::basic_istream<char>> dataStream;
     std::string mimeType;
     std::function<void(std::string_view data)> dataCallback;
 
     FileTransferRequest(std::string_view uri)
         : uri(uri), parentAct(getCurActivity()) { }
 
+    bool isUpload() const
+    {
+        return data || dataStream;
+    }
+
     std::string verb()
     {
-        return data ? "upload" : "download";
+        return isUpload() ? "upload" : "download";
     }
 };
 
@@ -94,6 +106,11 @@ struct FileTransferResult
      */
     std::string etag;
 
+    /**
+     * The HTTP status code of the response, or 0 for other protocols.
+     */
+    long httpStatus = 0;
+
     /**
      * All URLs visited in the redirect chain.
      */
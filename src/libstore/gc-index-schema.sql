@@ -0,0 +1,14 @@
+-- State of the last complete garbage collection, which incremental
+-- garbage collection uses to find the paths that may have become
+-- garbage since then.
+
+-- The roots (including temporary roots) found by that collection.
+create table if not exists GCRoots (
+    path text primary key not null
+);
+
+-- The highest path id when that collection started. Since path ids
+-- are never reused, paths with a higher id were registered after it.
+create table if not exists GCIndex (
+    maxPathId integer not null
+);
@@ -53,6 +53,16 @@ struct GCOptions
      * Stop after at least `maxFreed` bytes have been freed.
      */
     uint64_t maxFreed{std::numeric_limits<uint64_t>::max()};
+
+    /**
+     * For `gcReturnDead` and `gcDeleteDead`, only consider the paths
+     * that may have become garbage since the last complete garbage
+     * collection, i.e. the paths registered since then and those
+     * reachable from roots that have disappeared since then. This
+     * doesn't find invalid paths, or garbage due to a change of
+     * `keep-outputs` or `keep-derivations`.
+     */
+    bool incremental{false};
 };
 
 
@@ -457,6 +457,14 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
 
     StorePathSet roots, dead, alive;
 
+    /* A path handed to the deleter threads. */
+    struct Deletion
+    {
+        Path realPath;
+        std::optional<std::string> hashPart;
+        std::shared_ptr<AutoCloseFD> tmpDirFd;
+    };
+
     struct Shared
     {
         // The temp roots only store the hash part to make it easier to
@@ -466,6 +474,29 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
         // Hash part of the store path currently being deleted, if
         // any.
         std::optional<std::string> pending;
+
+        // Deletions that no deleter thread has picked up yet.
+        std::queue<Deletion> toDelete;
+
+        // Hash parts of the store paths that have been handed to the
+        // deleter threads but not yet deleted, and the number of
+        // such deletions (including those of non-store paths).
+        std::unordered_multiset<std::string> deleting;
+        size_t nrDeleting = 0;
+
+        // Whether the deleter threads should exit once `toDelete` is
+        // empty.
+        bool stopDeleting = false;
+
+        // The first error encountered by a deleter thread.
+        std::exception_ptr deleteError;
+
+        void finishDeletion(const Deletion & deletion)
+        {
+            nrDeleting--;
+            if (deletion.hashPart)
+                deleting.erase(deleting.find(*deletion.hashPart));
+        }
     };
 
     Sync<Shared> _shared;
@@ -490,6 +521,10 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
     auto fdGCLock = openGCLock();
     FdLock gcLock(fdGCLock.get(), ltWrite, true, "waiting for the big garbage collector lock...");
 
+    /* Paths registered from now on are new to the next incremental
+       collection. */
+    auto maxPathId = queryMaxPathId();
+
     /* Synchronisation point to test ENOENT handling in
        addTempRoot(), see tests/gc-non-blocking.sh. */
     if (auto p = getEnv("_NIX_TEST_GC_SYNC_1"))
@@ -579,7 +614,7 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
                                    done. FIXME: ideally we would use a
                                    FD for this so we don't block the
                                    poll loop. */
-                                while (shared->pending == hashPart) {
+                                while (shared->pending == hashPart || shared->deleting.count(hashPart)) {
                                     debug("synchronising with deletion of path '%s'", path);
                                     shared.wait(wakeup);
                                 }
@@ -628,8 +663,86 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
     if (auto p = getEnv("_NIX_TEST_GC_SYNC_2"))
         readFile(*p);
 
-    /* Helper function that deletes a path from the store and throws
-       GCLimitReached if we've deleted enough garbage. */
+    /* An incremental collection only has to consider the paths that
+       may have become garbage since the last complete collection:
+       those registered since, and those reachable from roots that
+       have disappeared since. */
+    std::optional<StorePathSet> candidates;
+    if (options.incremental
+        && (options.action == GCOptions::gcReturnDead || options.action == GCOptions::gcDeleteDead)
+        && !options.ignoreLiveness)
+    {
+        if (auto index = readGCIndex()) {
+            candidates = queryPathsRegisteredAfter(index->maxPathId);
+            for (auto & root : index->roots)
+                if (!roots.count(root) && isValidPath(root))
+                    computeFSClosure(root, *candidates,
+                        /* flipDirection */ false, gcKeepOutputs, gcKeepDerivations);
+            debug("%d paths may have become garbage", candidates->size());
+        } else
+            printInfo("no previous complete garbage collection, so doing a full one...");
+    }
+
+    /* Paths are deleted by a pool of threads, so that deleting a
+       large path doesn't hold up finding the other dead paths. */
+    unsigned int nrDeleters = settings.gcDeleteThreads;
+    if (!nrDeleters)
+        nrDeleters = std::max(1U, std::thread::hardware_concurrency());
+
+    std::vector<std::thread> deleters;
+
+    /* Stop the deleter threads. If we're bailing out early, deletions
+       that haven't started yet are dropped, so release any clients
+       waiting for them. */
+    Finally stopDeleters([&]() {
+        {
+            auto shared(_shared.lock());
+            shared->stopDeleting = true;
+            for (; !shared->toDelete.empty(); shared->toDelete.pop())
+                shared->finishDeletion(shared->toDelete.front());
+        }
+        wakeup.notify_all();
+        for (auto & thread : deleters)
+            thread.join();
+    });
+
+    for (unsigned int n = 0; n < nrDeleters; ++n)
+        deleters.emplace_back([&]() {
+            while (true) {
+                std::optional<Deletion> deletion;
+                {
+                    auto shared(_shared.lock());
+                    while (shared->toDelete.empty() && !shared->stopDeleting)
+                        shared.wait(wakeup);
+                    if (shared->toDelete.empty())
+                        return;
+                    deletion = std::move(shared->toDelete.front());
+                    shared->toDelete.pop();
+                }
+
+                uint64_t bytesFreed = 0;
+                std::exception_ptr error;
+
+                try {
+                    deleteStorePath(deletion->realPath, bytesFreed);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                {
+                    auto shared(_shared.lock());
+                    results.bytesFreed += bytesFreed;
+                    shared->finishDeletion(*deletion);
+                    if (error && !shared->deleteError)
+                        shared->deleteError = error;
+                }
+                wakeup.notify_all();
+            }
+        });
+
+    /* Helper function that schedules deletion of a path from the
+       store and throws GCLimitReached if we've deleted enough
+       garbage. */
     auto deleteFromStore = [&](std::string_view baseName)
     {
         Path path = storeDir + "/" + std::string(baseName);
@@ -638,9 +751,10 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
         /* There may be temp directories in the store that are still in use
            by another process. We need to be sure that we can acquire an
            exclusive lock before deleting them. */
+        auto tmpDirFd = std::make_shared<AutoCloseFD>();
         if (baseName.find("tmp-", 0) == 0) {
-            AutoCloseFD tmpDirFd = openDirectory(realPath);
-            if (!tmpDirFd || !lockFile(tmpDirFd.get(), ltWrite, false)) {
+            *tmpDirFd = openDirectory(realPath);
+            if (!*tmpDirFd || !lockFile(tmpDirFd->get(), ltWrite, false)) {
                 debug("skipping locked tempdir '%s'", realPath);
                 return;
             }
@@ -648,17 +762,36 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
 
         printInfo("deleting '%1%'", path);
 
-        results.paths.insert(path);
-
-        uint64_t bytesFreed;
-        deleteStorePath(realPath, bytesFreed);
+        /* Until the path is gone, clients adding it as a temporary
+           root have to wait, just like for the path that is currently
+           being examined. Also don't let too many deletions pile up,
+           to limit how far we go past `maxFreed`. */
+        std::optional<std::string> hashPart;
+        if (auto storePath = maybeParseStorePath(path))
+            hashPart = std::string(storePath->hashPart());
 
-        results.bytesFreed += bytesFreed;
+        {
+            auto shared(_shared.lock());
+            while (shared->nrDeleting >= 2 * nrDeleters && !shared->deleteError)
+                shared.wait(wakeup);
+            if (shared->deleteError)
+                std::rethrow_exception(shared->deleteError);
+            results.paths.insert(path);
+            shared->nrDeleting++;
+            if (hashPart)
+                shared->deleting.insert(*hashPart);
+            shared->toDelete.push({realPath, hashPart, tmpDirFd});
+        }
+        wakeup.notify_all();
 
-        if (results.bytesFreed > options.maxFreed) {
-            printInfo("deleted more than %d bytes; stopping", options.maxFreed);
-            throw GCLimitReached();
+        {
+            auto shared(_shared.lock());
+            if (results.bytesFreed <= options.maxFreed)
+                return;
         }
+
+        printInfo("deleted more than %d bytes; stopping", options.maxFreed);
+        throw GCLimitReached();
     };
 
     std::map<StorePath, StorePathSet> referrersCache;
@@ -780,6 +913,9 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
         }
     };
 
+    /* Whether we looked at every path that may be garbage. */
+    bool complete = false;
+
     /* Either delete all garbage paths, or just the specified
        paths (for gcDeleteSpecific). */
     if (options.action == GCOptions::gcDeleteSpecific) {
@@ -802,30 +938,57 @@ void LocalStore::collectGarbage(const GCOptions & options, GCResults & results)
             printInfo("determining live/dead paths...");
 
         try {
-            AutoCloseDir dir(opendir(realStoreDir.get().c_str()));
-            if (!dir) throw SysError("opening directory '%1%'", realStoreDir);
-
-            /* Read the store and delete all paths that are invalid or
-               unreachable. We don't use readDirectory() here so that
-               GCing can start faster. */
-            auto linksName = baseNameOf(linksDir);
-            Paths entries;
-            struct dirent * dirent;
-            while (errno = 0, dirent = readdir(dir.get())) {
-                checkInterrupt();
-                std::string name = dirent->d_name;
-                if (name == "." || name == ".." || name == linksName) continue;
-
-                if (auto storePath = maybeParseStorePath(storeDir + "/" + name))
-                    deleteReferrersClosure(*storePath);
-                else
-                    deleteFromStore(name);
+            if (candidates) {
+                for (auto & path : *candidates)
+                    deleteReferrersClosure(path);
+            } else {
+                AutoCloseDir dir(opendir(realStoreDir.get().c_str()));
+                if (!dir) throw SysError("opening directory '%1%'", realStoreDir);
+
+                /* Read the store and delete all paths that are invalid or
+                   unreachable. We don't use readDirectory() here so that
+                   GCing can start faster. */
+                auto linksName = baseNameOf(linksDir);
+                Paths entries;
+                struct dirent * dirent;
+                while (errno = 0, dirent = readdir(dir.get())) {
+                    checkInterrupt();
+                    std::string name = dirent->d_name;
+                    if (name == "." || name == ".." || name == linksName) continue;
+
+                    if (auto storePath = maybeParseStorePath(storeDir + "/" + name))
+                        deleteReferrersClosure(*storePath);
+                    else
+                        deleteFromStore(name);
 
+                }
             }
+            complete = true;
         } catch (GCLimitReached & e) {
         }
     }
 
+    /* Wait for the deleter threads to finish. */
+    {
+        auto shared(_shared.lock());
+        while (shared->nrDeleting && !shared->deleteError)
+            shared.wait(wakeup);
+        if (shared->deleteError)
+            std::rethrow_exception(shared->deleteError);
+    }
+
+    /* Now that every remaining path is reachable from the roots,
+       record them for the next incremental collection. This
+       includes the temporary roots received during the collection. */
+    if (complete && options.action == GCOptions::gcDeleteDead && !options.ignoreLiveness) {
+        GCIndex index{.roots = roots, .maxPathId = maxPathId};
+        auto tempRoots = _shared.lock()->tempRoots;
+        for (auto & hashPart : tempRoots)
+            if (auto path = queryPathFromHashPart(hashPart))
+                index.roots.insert(*path);
+        writeGCIndex(index);
+    }
+
     if (options.action == GCOptions::gcReturnLive) {
         for (auto & i : alive)
             results.paths.insert(printStorePath(i));
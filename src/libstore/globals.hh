@@ -41,8 +41,6 @@ const uint32_t maxIdsPerBuild =
 
 class Settings : public Config {
 
-    unsigned int getDefaultCores();
-
     StringSet getDefaultSystemFeatures();
 
     StringSet getDefaultExtraPlatforms();
@@ -55,6 +53,12 @@ public:
 
     Settings();
 
+    /**
+     * The number of CPU cores that Nix may use, taking the CPU
+     * quota of the current cgroup into account.
+     */
+    unsigned int getDefaultCores();
+
     Path nixPrefix;
 
     /**
@@ -179,6 +183,33 @@ public:
         // Don't document the machine-specific default value
         false};
 
+    Setting<unsigned int> maxLoad{
+        this, 0, "max-load",
+        R"(
+          Don't start a new local build while the 1-minute load average of the system is above this value, unless no local build is running.
+          Postponed builds are retried every [`build-poll-interval`](#conf-build-poll-interval) seconds.
+          A value of `0` (the default) disables this check.
+
+          When this is set and the load average exceeds the number of CPU cores, new builds get a proportionally smaller [`cores`](#conf-cores) value, down to 1.
+        )"};
+
+    Setting<uint64_t> minFreeMemory{
+        this, 0, "min-free-memory",
+        R"(
+          Don't start a new local build while the memory available to new processes (`MemAvailable` in `/proc/meminfo`) is below this many bytes, unless no local build is running.
+          This is only supported on Linux.
+          A value of `0` (the default) disables this check.
+        )"};
+
+    Setting<unsigned int> maxPressure{
+        this, 0, "max-pressure",
+        R"(
+          Don't start a new local build while some tasks were stalled waiting for CPU or memory for more than this percentage of the last 10 seconds, unless no local build is running.
+          This uses the Linux [pressure stall information](https://docs.kernel.org/accounting/psi.html).
+          If [`use-cgroups`](#conf-use-cgroups) is enabled, the pressure of each running build's cgroup is checked instead of that of the whole system.
+          A value of `0` (the default) disables this check.
+        )"};
+
     /**
      * Read-only mode.  Don't copy stuff to the store, don't change
      * the database.
@@ -566,6 +597,14 @@ public:
         )",
         {"gc-keep-derivations"}};
 
+    Setting<unsigned int> gcDeleteThreads{
+        this, 4, "gc-delete-threads",
+        R"(
+          The number of threads that delete dead store paths while the
+          garbage collector goes on to determine which other paths are
+          dead. The special value `0` means the number of CPU cores.
+        )"};
+
     Setting<bool> autoOptimiseStore{
         this, false, "auto-optimise-store",
         R"(
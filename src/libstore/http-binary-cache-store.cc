@@ -43,6 +43,12 @@ private:
     {
         bool enabled = true;
         std::chrono::steady_clock::time_point disabledUntil;
+
+        /**
+         * Whether the server honours range requests. If it doesn't,
+         * each probe would download an entire NAR, so stop asking.
+         */
+        bool rangeRequests = true;
     };
 
     Sync<State> _state;
@@ -132,7 +138,7 @@ protected:
         const std::string & mimeType) override
     {
         auto req = makeRequest(path);
-        req.data = StreamToSourceAdapter(istream).drain();
+        req.dataStream = istream;
         req.mimeType = mimeType;
         try {
             getFileTransfer()->upload(req);
@@ -164,6 +170,33 @@ protected:
         }
     }
 
+    std::optional<std::string> getFileRange(const std::string & path, uint64_t offset, uint64_t length) override
+    {
+        checkEnabled();
+        if (!_state.lock()->rangeRequests) return std::nullopt;
+        auto request(makeRequest(path));
+        request.headers.emplace_back("Range", fmt("bytes=%d-%d", offset, offset + length - 1));
+        try {
+            auto result = getFileTransfer()->download(std::move(request));
+            /* Servers that don't support range requests send the
+               entire file with status 200. */
+            if (result.httpStatus != 206) {
+                debug("binary cache '%s' does not support range requests", getUri());
+                _state.lock()->rangeRequests = false;
+                return std::nullopt;
+            }
+            if (result.data.size() != length)
+                throw Error("range request for '%s' in binary cache '%s' returned %d bytes, expected %d",
+                    path, getUri(), result.data.size(), length);
+            return std::move(result.data);
+        } catch (FileTransferError & e) {
+            if (e.error == FileTransfer::NotFound || e.error == FileTransfer::Forbidden)
+                throw NoSuchBinaryCacheFile("file '%s' does not exist in binary cache '%s'", path, getUri());
+            maybeDisable();
+            throw;
+        }
+    }
+
     void getFile(const std::string & path,
         Callback<std::optional<std::string>> callback) noexcept override
     {
@@ -3,6 +3,8 @@
 #include "nar-info-disk-cache.hh"
 #include "signals.hh"
 
+#include <fcntl.h>
+
 #include <atomic>
 
 namespace nix {
@@ -80,6 +82,28 @@ protected:
         }
     }
 
+    std::optional<std::string> getFileRange(const std::string & path, uint64_t offset, uint64_t length) override
+    {
+        auto path2 = binaryCacheDir + "/" + path;
+        AutoCloseFD fd = toDescriptor(open(path2.c_str(), O_RDONLY
+        #ifndef _WIN32
+            | O_CLOEXEC
+        #endif
+            ));
+        if (!fd) {
+            if (errno == ENOENT)
+                throw NoSuchBinaryCacheFile("file '%s' does not exist in binary cache", path);
+            throw SysError("opening '%s'", path2);
+        }
+
+        if (lseek(fromDescriptorReadOnly(fd.get()), offset, SEEK_SET) != (off_t) offset)
+            throw SysError("seeking in '%s'", path2);
+
+        std::string buf(length, 0);
+        readFull(fd.get(), buf.data(), length);
+        return buf;
+    }
+
     StorePathSet queryAllValidPaths() override
     {
         StorePathSet paths;
@@ -17,6 +17,7 @@
 #include "posix-source-accessor.hh"
 #include "keys.hh"
 #include "users.hh"
+#include "thread-pool.hh"
 
 #include <iostream>
 #include <algorithm>
@@ -24,6 +25,7 @@
 
 #include <memory>
 #include <new>
+#include <thread>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -93,6 +95,10 @@ struct LocalStore::State::Stmts {
     SQLiteStmt QueryValidPaths;
     SQLiteStmt QueryRealisationReferences;
     SQLiteStmt AddRealisationReference;
+    SQLiteStmt AddClosureStart;
+    SQLiteStmt ClearClosureStart;
+    SQLiteStmt QueryClosure;
+    SQLiteStmt QueryReverseClosure;
 };
 
 LocalStore::LocalStore(
@@ -303,40 +309,82 @@ LocalStore::LocalStore(
 
     upgradeDBSchema(*state);
 
-    /* Prepare SQL statements. */
-    state->stmts->RegisterValidPath.create(state->db,
+    prepareStatements(*state);
+
+    if (settings.useSQLiteWAL || readOnly)
+        readPool = std::make_unique<Pool<State>>(
+            std::max(1U, std::thread::hardware_concurrency()),
+            [this]() {
+                auto state = make_ref<State>();
+                /* Unlike `pragma query_only`, read-only connections
+                   can still write to temporary tables. */
+                state->db = SQLite(dbDir + "/db.sqlite",
+                    readOnly ? SQLiteOpenMode::Immutable : SQLiteOpenMode::ReadOnly);
+                state->stmts = std::make_unique<State::Stmts>();
+                prepareStatements(*state);
+                return state;
+            });
+}
+
+
+void LocalStore::prepareStatements(State & state)
+{
+    state.stmts->RegisterValidPath.create(state.db,
         "insert into ValidPaths (path, hash, registrationTime, deriver, narSize, ultimate, sigs, ca) values (?, ?, ?, ?, ?, ?, ?, ?);");
-    state->stmts->UpdatePathInfo.create(state->db,
+    state.stmts->UpdatePathInfo.create(state.db,
         "update ValidPaths set narSize = ?, hash = ?, ultimate = ?, sigs = ?, ca = ? where path = ?;");
-    state->stmts->AddReference.create(state->db,
+    state.stmts->AddReference.create(state.db,
         "insert or replace into Refs (referrer, reference) values (?, ?);");
-    state->stmts->QueryPathInfo.create(state->db,
+    state.stmts->QueryPathInfo.create(state.db,
         "select id, hash, registrationTime, deriver, narSize, ultimate, sigs, ca from ValidPaths where path = ?;");
-    state->stmts->QueryReferences.create(state->db,
+    state.stmts->QueryReferences.create(state.db,
         "select path from Refs join ValidPaths on reference = id where referrer = ?;");
-    state->stmts->QueryReferrers.create(state->db,
+    state.stmts->QueryReferrers.create(state.db,
         "select path from Refs join ValidPaths on referrer = id where reference = (select id from ValidPaths where path = ?);");
-    state->stmts->InvalidatePath.create(state->db,
+    state.stmts->InvalidatePath.create(state.db,
         "delete from ValidPaths where path = ?;");
-    state->stmts->AddDerivationOutput.create(state->db,
+    state.stmts->AddDerivationOutput.create(state.db,
         "insert or replace into DerivationOutputs (drv, id, path) values (?, ?, ?);");
-    state->stmts->QueryValidDerivers.create(state->db,
+    state.stmts->QueryValidDerivers.create(state.db,
         "select v.id, v.path from DerivationOutputs d join ValidPaths v on d.drv = v.id where d.path = ?;");
-    state->stmts->QueryDerivationOutputs.create(state->db,
+    state.stmts->QueryDerivationOutputs.create(state.db,
         "select id, path from DerivationOutputs where drv = ?;");
     // Use "path >= ?" with limit 1 rather than "path like '?%'" to
     // ensure efficient lookup.
-    state->stmts->QueryPathFromHashPart.create(state->db,
+    state.stmts->QueryPathFromHashPart.create(state.db,
         "select path from ValidPaths where path >= ? limit 1;");
-    state->stmts->QueryValidPaths.create(state->db, "select path from ValidPaths");
+    state.stmts->QueryValidPaths.create(state.db, "select path from ValidPaths");
+    /* The start paths of computeFSClosure(). */
+    state.db.exec("pragma temp_store = memory");
+    state.db.exec("create temp table if not exists ClosureStart (path text primary key not null)");
+    state.stmts->AddClosureStart.create(state.db,
+        "insert or ignore into temp.ClosureStart (path) values (?);");
+    state.stmts->ClearClosureStart.create(state.db,
+        "delete from temp.ClosureStart;");
+    state.stmts->QueryClosure.create(state.db,
+        R"(
+            with recursive Closure(id) as (
+                select id from ValidPaths where path in (select path from temp.ClosureStart)
+                union
+                select Refs.reference from Refs join Closure on Refs.referrer = Closure.id)
+            select path from ValidPaths join Closure on ValidPaths.id = Closure.id;
+        )");
+    state.stmts->QueryReverseClosure.create(state.db,
+        R"(
+            with recursive Closure(id) as (
+                select id from ValidPaths where path in (select path from temp.ClosureStart)
+                union
+                select Refs.referrer from Refs join Closure on Refs.reference = Closure.id)
+            select path from ValidPaths join Closure on ValidPaths.id = Closure.id;
+        )");
     if (experimentalFeatureSettings.isEnabled(Xp::CaDerivations)) {
-        state->stmts->RegisterRealisedOutput.create(state->db,
+        state.stmts->RegisterRealisedOutput.create(state.db,
             R"(
                 insert into Realisations (drvPath, outputName, outputPath, signatures)
                 values (?, ?, (select id from ValidPaths where path = ?), ?)
                 ;
             )");
-        state->stmts->UpdateRealisedOutput.create(state->db,
+        state.stmts->UpdateRealisedOutput.create(state.db,
             R"(
                 update Realisations
                     set signatures = ?
@@ -345,27 +393,27 @@ LocalStore::LocalStore(
                     outputName = ?
                 ;
             )");
-        state->stmts->QueryRealisedOutput.create(state->db,
+        state.stmts->QueryRealisedOutput.create(state.db,
             R"(
                 select Realisations.id, Output.path, Realisations.signatures from Realisations
                     inner join ValidPaths as Output on Output.id = Realisations.outputPath
                     where drvPath = ? and outputName = ?
                     ;
             )");
-        state->stmts->QueryAllRealisedOutputs.create(state->db,
+        state.stmts->QueryAllRealisedOutputs.create(state.db,
             R"(
                 select outputName, Output.path from Realisations
                     inner join ValidPaths as Output on Output.id = Realisations.outputPath
                     where drvPath = ?
                     ;
             )");
-        state->stmts->QueryRealisationReferences.create(state->db,
+        state.stmts->QueryRealisationReferences.create(state.db,
             R"(
                 select drvPath, outputName from Realisations
                     join RealisationsRefs on realisationReference = Realisations.id
                     where referrer = ?;
             )");
-        state->stmts->AddRealisationReference.create(state->db,
+        state.stmts->AddRealisationReference.create(state.db,
             R"(
                 insert or replace into RealisationsRefs (referrer, realisationReference)
                 values (
@@ -376,6 +424,51 @@ LocalStore::LocalStore(
 }
 
 
+thread_local LocalStore::WriteTxn * LocalStore::WriteTxn::current = nullptr;
+
+
+LocalStore::WriteTxn::WriteTxn(LocalStore & store, State & state)
+    : store(store)
+    , state(state)
+    , txn(state.db)
+    , prev(current)
+{
+    current = this;
+}
+
+
+LocalStore::WriteTxn::~WriteTxn()
+{
+    current = prev;
+}
+
+
+void LocalStore::WriteTxn::commit()
+{
+    txn.commit();
+}
+
+
+template<typename T>
+T LocalStore::retryReadSQLite(std::function<T(State &)> fun)
+{
+    /* `_state` is already locked by this thread, and the caller
+       takes care of retrying the whole transaction. */
+    for (auto t = WriteTxn::current; t; t = t->prev)
+        if (&t->store == this)
+            return fun(t->state);
+
+    return retrySQLite<T>([&]() {
+        if (readPool) {
+            auto state(readPool->get());
+            return fun(*state);
+        }
+        auto state(_state.lock());
+        return fun(*state);
+    });
+}
+
+
 LocalStore::LocalStore(const Params & params)
     : LocalStore("local", "", params)
 {
@@ -562,6 +655,12 @@ void LocalStore::upgradeDBSchema(State & state)
             "20220326-ca-derivations",
             #include "ca-specific-schema.sql.gen.hh"
             );
+
+    if (!readOnly)
+        doUpgrade(
+            "20261018-gc-index",
+            #include "gc-index-schema.sql.gen.hh"
+            );
 }
 
 
@@ -718,15 +817,30 @@ void LocalStore::queryPathInfoUncached(const StorePath & path,
     Callback<std::shared_ptr<const ValidPathInfo>> callback) noexcept
 {
     try {
-        callback(retrySQLite<std::shared_ptr<const ValidPathInfo>>([&]() {
-            auto state(_state.lock());
-            return queryPathInfoInternal(*state, path);
+        callback(retryReadSQLite<std::shared_ptr<const ValidPathInfo>>([&](State & state) {
+            return queryPathInfoInternal(state, path);
         }));
 
     } catch (...) { callback.rethrow(); }
 }
 
 
+std::map<StorePath, std::shared_ptr<const ValidPathInfo>> LocalStore::queryPathInfosUncached(const StorePathSet & paths)
+{
+    return retryReadSQLite<std::map<StorePath, std::shared_ptr<const ValidPathInfo>>>([&](State & state) {
+        /* Read all paths from a single snapshot of the database
+           (which an open write transaction already is). */
+        std::optional<SQLiteTxn> txn;
+        if (sqlite3_get_autocommit(state.db)) txn.emplace(state.db);
+        std::map<StorePath, std::shared_ptr<const ValidPathInfo>> infos;
+        for (auto & path : paths)
+            infos.insert_or_assign(path, queryPathInfoInternal(state, path));
+        if (txn) txn->commit();
+        return infos;
+    });
+}
+
+
 std::shared_ptr<const ValidPathInfo> LocalStore::queryPathInfoInternal(State & state, const StorePath & path)
 {
     /* Get the path info. */
@@ -805,9 +919,8 @@ bool LocalStore::isValidPath_(State & state, const StorePath & path)
 
 bool LocalStore::isValidPathUncached(const StorePath & path)
 {
-    return retrySQLite<bool>([&]() {
-        auto state(_state.lock());
-        return isValidPath_(*state, path);
+    return retryReadSQLite<bool>([&](State & state) {
+        return isValidPath_(state, path);
     });
 }
 
@@ -823,9 +936,8 @@ StorePathSet LocalStore::queryValidPaths(const StorePathSet & paths, SubstituteF
 
 StorePathSet LocalStore::queryAllValidPaths()
 {
-    return retrySQLite<StorePathSet>([&]() {
-        auto state(_state.lock());
-        auto use(state->stmts->QueryValidPaths.use());
+    return retryReadSQLite<StorePathSet>([&](State & state) {
+        auto use(state.stmts->QueryValidPaths.use());
         StorePathSet res;
         while (use.next()) res.insert(parseStorePath(use.getStr(0)));
         return res;
@@ -833,6 +945,78 @@ StorePathSet LocalStore::queryAllValidPaths()
 }
 
 
+uint64_t LocalStore::queryMaxPathId()
+{
+    return retryReadSQLite<uint64_t>([&](State & state) -> uint64_t {
+        SQLiteStmt stmt(state.db, "select max(id) from ValidPaths");
+        auto use(stmt.use());
+        if (!use.next() || use.isNull(0))
+            return 0;
+        return use.getInt(0);
+    });
+}
+
+
+StorePathSet LocalStore::queryPathsRegisteredAfter(uint64_t pathId)
+{
+    return retryReadSQLite<StorePathSet>([&](State & state) {
+        SQLiteStmt stmt(state.db, "select path from ValidPaths where id > ?");
+        auto use(stmt.use()((int64_t) pathId));
+        StorePathSet res;
+        while (use.next())
+            res.insert(parseStorePath(use.getStr(0)));
+        return res;
+    });
+}
+
+
+std::optional<LocalStore::GCIndex> LocalStore::readGCIndex()
+{
+    return retryReadSQLite<std::optional<GCIndex>>([&](State & state) -> std::optional<GCIndex> {
+        std::optional<SQLiteTxn> txn;
+        if (sqlite3_get_autocommit(state.db)) txn.emplace(state.db);
+        GCIndex index;
+
+        {
+            SQLiteStmt stmt(state.db, "select maxPathId from GCIndex");
+            auto use(stmt.use());
+            if (!use.next())
+                return std::nullopt;
+            index.maxPathId = use.getInt(0);
+        }
+
+        {
+            SQLiteStmt stmt(state.db, "select path from GCRoots");
+            auto use(stmt.use());
+            while (use.next())
+                index.roots.insert(parseStorePath(use.getStr(0)));
+        }
+
+        if (txn) txn->commit();
+        return index;
+    });
+}
+
+
+void LocalStore::writeGCIndex(const GCIndex & index)
+{
+    retrySQLite<void>([&]() {
+        auto state(_state.lock());
+        WriteTxn txn(*this, *state);
+
+        state->db.exec("delete from GCIndex; delete from GCRoots");
+        SQLiteStmt(state->db, "insert into GCIndex (maxPathId) values (?)").use()
+            ((int64_t) index.maxPathId).exec();
+
+        SQLiteStmt stmt(state->db, "insert into GCRoots (path) values (?)");
+        for (auto & root : index.roots)
+            stmt.use()(printStorePath(root)).exec();
+
+        txn.commit();
+    });
+}
+
+
 void LocalStore::queryReferrers(State & state, const StorePath & path, StorePathSet & referrers)
 {
     auto useQueryReferrers(state.stmts->QueryReferrers.use()(printStorePath(path)));
@@ -844,19 +1028,59 @@ void LocalStore::queryReferrers(State & state, const StorePath & path, StorePath
 
 void LocalStore::queryReferrers(const StorePath & path, StorePathSet & referrers)
 {
-    return retrySQLite<void>([&]() {
-        auto state(_state.lock());
-        queryReferrers(*state, path, referrers);
+    return retryReadSQLite<void>([&](State & state) {
+        queryReferrers(state, path, referrers);
     });
 }
 
 
-StorePathSet LocalStore::queryValidDerivers(const StorePath & path)
+void LocalStore::computeFSClosure(const StorePathSet & startPaths,
+    StorePathSet & out, bool flipDirection, bool includeOutputs, bool includeDerivers)
 {
-    return retrySQLite<StorePathSet>([&]() {
-        auto state(_state.lock());
+    if (includeOutputs || includeDerivers)
+        return Store::computeFSClosure(startPaths, out, flipDirection, includeOutputs, includeDerivers);
+
+    std::vector<StorePath> todo;
+    for (auto & path : startPaths)
+        if (!out.count(path))
+            todo.push_back(path);
+
+    if (todo.empty()) return;
 
-        auto useQueryValidDerivers(state->stmts->QueryValidDerivers.use()(printStorePath(path)));
+    /* Compute the closure of all start paths in a single query, so
+       that the parts they share are only visited once. */
+    auto closure = retryReadSQLite<StorePathSet>([&](State & state) {
+        state.stmts->ClearClosureStart.use().exec();
+        for (auto & path : todo)
+            state.stmts->AddClosureStart.use()(printStorePath(path)).exec();
+
+        StorePathSet res;
+        {
+            auto use((flipDirection ? state.stmts->QueryReverseClosure : state.stmts->QueryClosure).use());
+            while (use.next())
+                res.insert(parseStorePath(use.getStr(0)));
+        }
+
+        state.stmts->ClearClosureStart.use().exec();
+        return res;
+    });
+
+    /* A valid start path is always part of its own closure. */
+    for (auto & path : todo)
+        if (!closure.count(path)) {
+            if (!flipDirection)
+                throw InvalidPath("path '%s' is not valid", printStorePath(path));
+            out.insert(path);
+        }
+
+    out.merge(closure);
+}
+
+
+StorePathSet LocalStore::queryValidDerivers(const StorePath & path)
+{
+    return retryReadSQLite<StorePathSet>([&](State & state) {
+        auto useQueryValidDerivers(state.stmts->QueryValidDerivers.use()(printStorePath(path)));
 
         StorePathSet derivers;
         while (useQueryValidDerivers.next())
@@ -870,12 +1094,11 @@ StorePathSet LocalStore::queryValidDerivers(const StorePath & path)
 std::map<std::string, std::optional<StorePath>>
 LocalStore::queryStaticPartialDerivationOutputMap(const StorePath & path)
 {
-    return retrySQLite<std::map<std::string, std::optional<StorePath>>>([&]() {
-        auto state(_state.lock());
+    return retryReadSQLite<std::map<std::string, std::optional<StorePath>>>([&](State & state) {
         std::map<std::string, std::optional<StorePath>> outputs;
         uint64_t drvId;
-        drvId = queryValidPathId(*state, path);
-        auto use(state->stmts->QueryDerivationOutputs.use()(drvId));
+        drvId = queryValidPathId(state, path);
+        auto use(state.stmts->QueryDerivationOutputs.use()(drvId));
         while (use.next())
             outputs.insert_or_assign(
                 use.getStr(0), parseStorePath(use.getStr(1)));
@@ -890,14 +1113,12 @@ std::optional<StorePath> LocalStore::queryPathFromHashPart(const std::string & h
 
     Path prefix = storeDir + "/" + hashPart;
 
-    return retrySQLite<std::optional<StorePath>>([&]() -> std::optional<StorePath> {
-        auto state(_state.lock());
-
-        auto useQueryPathFromHashPart(state->stmts->QueryPathFromHashPart.use()(prefix));
+    return retryReadSQLite<std::optional<StorePath>>([&](State & state) -> std::optional<StorePath> {
+        auto useQueryPathFromHashPart(state.stmts->QueryPathFromHashPart.use()(prefix));
 
         if (!useQueryPathFromHashPart.next()) return {};
 
-        const char * s = (const char *) sqlite3_column_text(state->stmts->QueryPathFromHashPart, 0);
+        const char * s = (const char *) sqlite3_column_text(state.stmts->QueryPathFromHashPart, 0);
         if (s && prefix.compare(0, prefix.size(), s, prefix.size()) == 0)
             return parseStorePath(s);
         return {};
@@ -952,54 +1173,135 @@ void LocalStore::registerValidPaths(const ValidPathInfos & infos)
     if (settings.syncBeforeRegistering) sync();
 #endif
 
-    return retrySQLite<void>([&]() {
-        auto state(_state.lock());
+    PendingRegistration registration{infos};
+    std::vector<PendingRegistration *> batch;
 
-        SQLiteTxn txn(state->db);
-        StorePathSet paths;
-
-        for (auto & [_, i] : infos) {
-            assert(i.narHash.algo == HashAlgorithm::SHA256);
-            if (isValidPath_(*state, i.path))
-                updatePathInfo(*state, i);
-            else
-                addValidPath(*state, i, false);
-            paths.insert(i.path);
+    {
+        auto groupCommit(_groupCommit.lock());
+        groupCommit->queue.push_back(&registration);
+        while (groupCommit->committing && !registration.done)
+            groupCommit.wait(groupCommitCV);
+        if (!registration.done) {
+            /* It's our turn: commit everything that was queued while
+               the previous transaction was being committed. */
+            groupCommit->committing = true;
+            batch = std::move(groupCommit->queue);
+            groupCommit->queue.clear();
         }
+    }
 
-        for (auto & [_, i] : infos) {
-            auto referrer = queryValidPathId(*state, i.path);
-            for (auto & j : i.references)
-                state->stmts->AddReference.use()(referrer)(queryValidPathId(*state, j)).exec();
-        }
+    if (!batch.empty()) {
+        Finally finishBatch([&]() {
+            {
+                auto groupCommit(_groupCommit.lock());
+                groupCommit->committing = false;
+                for (auto r : batch)
+                    r->done = true;
+            }
+            groupCommitCV.notify_all();
+        });
+        commitRegistrations(batch);
+    }
+
+    if (registration.exception)
+        std::rethrow_exception(registration.exception);
+}
+
+
+void LocalStore::commitRegistrations(const std::vector<PendingRegistration *> & batch)
+{
+    /* addValidPath() caches the path info before the transaction is
+       committed, so forget the paths of registrations that were
+       rolled back. */
+    auto forgetPaths = [&](const ValidPathInfos & infos) {
+        auto state_(Store::state.lock());
+        for (auto & [path, _] : infos)
+            state_->pathInfoCache.erase(std::string(path.to_string()));
+    };
+
+    try {
+        retrySQLite<void>([&]() {
+            auto state(_state.lock());
+
+            WriteTxn txn(*this, *state);
 
-        /* Check that the derivation outputs are correct.  We can't do
-           this in addValidPath() above, because the references might
-           not be valid yet. */
-        for (auto & [_, i] : infos)
-            if (i.path.isDerivation()) {
-                // FIXME: inefficient; we already loaded the derivation in addValidPath().
-                readInvalidDerivation(i.path).checkInvariants(*this, i.path);
+            /* Use a savepoint per registration so that an invalid
+               registration doesn't fail the others. */
+            for (auto r : batch) {
+                r->exception = nullptr;
+                state->db.exec("savepoint registration");
+                try {
+                    registerValidPaths_(*state, r->infos);
+                } catch (SQLiteBusy &) {
+                    throw;
+                } catch (Interrupted &) {
+                    throw;
+                } catch (...) {
+                    r->exception = std::current_exception();
+                    state->db.exec("rollback to registration");
+                    forgetPaths(r->infos);
+                }
+                state->db.exec("release registration");
             }
 
-        /* Do a topological sort of the paths.  This will throw an
-           error if a cycle is detected and roll back the
-           transaction.  Cycles can only occur when a derivation
-           has multiple outputs. */
-        topoSort(paths,
-            {[&](const StorePath & path) {
-                auto i = infos.find(path);
-                return i == infos.end() ? StorePathSet() : i->second.references;
-            }},
-            {[&](const StorePath & path, const StorePath & parent) {
-                return BuildError(
-                    "cycle detected in the references of '%s' from '%s'",
-                    printStorePath(path),
-                    printStorePath(parent));
-            }});
+            txn.commit();
+        });
+    } catch (...) {
+        /* The whole batch failed. Every caller gets the same
+           exception, so that its type (e.g. Interrupted) is kept. */
+        auto exception = std::current_exception();
+        for (auto r : batch) {
+            forgetPaths(r->infos);
+            r->exception = exception;
+        }
+        throw;
+    }
+}
 
-        txn.commit();
-    });
+
+void LocalStore::registerValidPaths_(State & state, const ValidPathInfos & infos)
+{
+    StorePathSet paths;
+
+    for (auto & [_, i] : infos) {
+        assert(i.narHash.algo == HashAlgorithm::SHA256);
+        if (isValidPath_(state, i.path))
+            updatePathInfo(state, i);
+        else
+            addValidPath(state, i, false);
+        paths.insert(i.path);
+    }
+
+    for (auto & [_, i] : infos) {
+        auto referrer = queryValidPathId(state, i.path);
+        for (auto & j : i.references)
+            state.stmts->AddReference.use()(referrer)(queryValidPathId(state, j)).exec();
+    }
+
+    /* Check that the derivation outputs are correct.  We can't do
+       this in addValidPath() above, because the references might
+       not be valid yet. */
+    for (auto & [_, i] : infos)
+        if (i.path.isDerivation()) {
+            // FIXME: inefficient; we already loaded the derivation in addValidPath().
+            readInvalidDerivation(i.path).checkInvariants(*this, i.path);
+        }
+
+    /* Do a topological sort of the paths.  This will throw an
+       error if a cycle is detected and roll back the
+       registration.  Cycles can only occur when a derivation
+       has multiple outputs. */
+    topoSort(paths,
+        {[&](const StorePath & path) {
+            auto i = infos.find(path);
+            return i == infos.end() ? StorePathSet() : i->second.references;
+        }},
+        {[&](const StorePath & path, const StorePath & parent) {
+            return BuildError(
+                "cycle detected in the references of '%s' from '%s'",
+                printStorePath(path),
+                printStorePath(parent));
+        }});
 }
 
 
@@ -1348,7 +1650,7 @@ void LocalStore::invalidatePathChecked(const StorePath & path)
     retrySQLite<void>([&]() {
         auto state(_state.lock());
 
-        SQLiteTxn txn(state->db);
+        WriteTxn txn(*this, *state);
 
         if (isValidPath_(*state, path)) {
             StorePathSet referrers; queryReferrers(*state, path, referrers);
@@ -1373,85 +1675,126 @@ bool LocalStore::verifyStore(bool checkContents, RepairFlag repair)
     auto fdGCLock = openGCLock();
     FdLock gcLock(fdGCLock.get(), ltRead, true, "waiting for the big garbage collector lock...");
 
-    auto [errors, validPaths] = verifyAllValidPaths(repair);
+    auto [errors_, validPaths] = verifyAllValidPaths(repair);
+    std::atomic<bool> errors = errors_;
 
     /* Optionally, check the content hashes (slow). */
     if (checkContents) {
 
+        /* Hashing is the expensive part, so check the links and store
+           paths concurrently. */
         printInfo("checking link hashes...");
 
-        for (auto & link : std::filesystem::directory_iterator{linksDir}) {
-            checkInterrupt();
-            auto name = link.path().filename();
-            printMsg(lvlTalkative, "checking contents of '%s'", name);
-            PosixSourceAccessor accessor;
-            std::string hash = hashPath(
-                PosixSourceAccessor::createAtRoot(link.path()),
-                FileIngestionMethod::NixArchive, HashAlgorithm::SHA256).first.to_string(HashFormat::Nix32, false);
-            if (hash != name.string()) {
-                printError("link '%s' was modified! expected hash '%s', got '%s'",
-                    link.path(), name, hash);
-                if (repair) {
-                    std::filesystem::remove(link.path());
-                    printInfo("removed link '%s'", link.path());
-                } else {
-                    errors = true;
-                }
+        {
+            ThreadPool pool;
+
+            for (auto & link : std::filesystem::directory_iterator{linksDir}) {
+                pool.enqueue([&, path(link.path())]() {
+                    checkInterrupt();
+                    auto name = path.filename();
+                    printMsg(lvlTalkative, "checking contents of '%s'", name);
+                    std::string hash = hashPath(
+                        PosixSourceAccessor::createAtRoot(path),
+                        FileIngestionMethod::NixArchive, HashAlgorithm::SHA256).first.to_string(HashFormat::Nix32, false);
+                    if (hash != name.string()) {
+                        printError("link '%s' was modified! expected hash '%s', got '%s'",
+                            path, name, hash);
+                        if (repair) {
+                            std::filesystem::remove(path);
+                            printInfo("removed link '%s'", path);
+                        } else {
+                            errors = true;
+                        }
+                    }
+                });
             }
+
+            pool.process();
         }
 
         printInfo("checking store hashes...");
 
         Hash nullHash(HashAlgorithm::SHA256);
 
+        /* Only the hashing is done concurrently. Repairs and database
+           updates are collected and done sequentially afterwards. */
+        struct Fixes
+        {
+            StorePathSet toRepair;
+            std::vector<ValidPathInfo> toUpdate;
+        };
+
+        Sync<Fixes> fixes_;
+
+        ThreadPool pool;
+
         for (auto & i : validPaths) {
-            try {
-                auto info = std::const_pointer_cast<ValidPathInfo>(std::shared_ptr<const ValidPathInfo>(queryPathInfo(i)));
+            pool.enqueue([&, i]() {
+                checkInterrupt();
+                try {
+                    auto info = *queryPathInfo(i);
 
-                /* Check the content hash (optionally - slow). */
-                printMsg(lvlTalkative, "checking contents of '%s'", printStorePath(i));
+                    /* Check the content hash (optionally - slow). */
+                    printMsg(lvlTalkative, "checking contents of '%s'", printStorePath(i));
 
-                auto hashSink = HashSink(info->narHash.algo);
+                    auto hashSink = HashSink(info.narHash.algo);
 
-                dumpPath(Store::toRealPath(i), hashSink);
-                auto current = hashSink.finish();
+                    dumpPath(Store::toRealPath(i), hashSink);
+                    auto current = hashSink.finish();
 
-                if (info->narHash != nullHash && info->narHash != current.first) {
-                    printError("path '%s' was modified! expected hash '%s', got '%s'",
-                               printStorePath(i), info->narHash.to_string(HashFormat::Nix32, true), current.first.to_string(HashFormat::Nix32, true));
-                    if (repair) repairPath(i); else errors = true;
-                } else {
+                    if (info.narHash != nullHash && info.narHash != current.first) {
+                        printError("path '%s' was modified! expected hash '%s', got '%s'",
+                                   printStorePath(i), info.narHash.to_string(HashFormat::Nix32, true), current.first.to_string(HashFormat::Nix32, true));
+                        if (repair) fixes_.lock()->toRepair.insert(i); else errors = true;
+                    } else {
 
-                    bool update = false;
+                        bool update = false;
 
-                    /* Fill in missing hashes. */
-                    if (info->narHash == nullHash) {
-                        printInfo("fixing missing hash on '%s'", printStorePath(i));
-                        info->narHash = current.first;
-                        update = true;
-                    }
+                        /* Fill in missing hashes. */
+                        if (info.narHash == nullHash) {
+                            printInfo("fixing missing hash on '%s'", printStorePath(i));
+                            info.narHash = current.first;
+                            update = true;
+                        }
 
-                    /* Fill in missing narSize fields (from old stores). */
-                    if (info->narSize == 0) {
-                        printInfo("updating size field on '%s' to %s", printStorePath(i), current.second);
-                        info->narSize = current.second;
-                        update = true;
-                    }
+                        /* Fill in missing narSize fields (from old stores). */
+                        if (info.narSize == 0) {
+                            printInfo("updating size field on '%s' to %s", printStorePath(i), current.second);
+                            info.narSize = current.second;
+                            update = true;
+                        }
+
+                        if (update)
+                            fixes_.lock()->toUpdate.push_back(std::move(info));
 
-                    if (update) {
-                        auto state(_state.lock());
-                        updatePathInfo(*state, *info);
                     }
 
+                } catch (Error & e) {
+                    /* It's possible that the path got GC'ed, so ignore
+                       errors on invalid paths. */
+                    if (isValidPath(i))
+                        logError(e.info());
+                    else
+                        warn(e.msg());
+                    errors = true;
                 }
+            });
+        }
+
+        pool.process();
 
+        auto fixes(fixes_.lock());
+
+        for (auto & info : fixes->toUpdate) {
+            auto state(_state.lock());
+            updatePathInfo(*state, info);
+        }
+
+        for (auto & path : fixes->toRepair) {
+            try {
+                repairPath(path);
             } catch (Error & e) {
-                /* It's possible that the path got GC'ed, so ignore
-                   errors on invalid paths. */
-                if (isValidPath(i))
-                    logError(e.info());
-                else
-                    warn(e.msg());
+                logError(e.info());
                 errors = true;
             }
         }
@@ -1569,7 +1912,7 @@ void LocalStore::addSignatures(const StorePath & storePath, const StringSet & si
     retrySQLite<void>([&]() {
         auto state(_state.lock());
 
-        SQLiteTxn txn(state->db);
+        WriteTxn txn(*this, *state);
 
         auto info = std::const_pointer_cast<ValidPathInfo>(queryPathInfoInternal(*state, storePath));
 
@@ -1668,9 +2011,8 @@ void LocalStore::queryRealisationUncached(const DrvOutput & id,
 {
     try {
         auto maybeRealisation
-            = retrySQLite<std::optional<const Realisation>>([&]() {
-                  auto state(_state.lock());
-                  return queryRealisation_(*state, id);
+            = retryReadSQLite<std::optional<const Realisation>>([&](State & state) {
+                  return queryRealisation_(state, id);
               });
         if (maybeRealisation)
             callback(
@@ -4,11 +4,13 @@
 #include "sqlite.hh"
 
 #include "pathlocks.hh"
+#include "pool.hh"
 #include "store-api.hh"
 #include "indirect-root-store.hh"
 #include "sync.hh"
 
 #include <chrono>
+#include <condition_variable>
 #include <future>
 #include <string>
 #include <unordered_set>
@@ -120,6 +122,73 @@ private:
 
     Sync<State> _state;
 
+    /**
+     * Additional database connections that are only used for
+     * queries, so that concurrent queries don't wait for each other
+     * or for writes on `_state`. This is only used in WAL mode, in
+     * which readers don't block the writer.
+     */
+    std::unique_ptr<Pool<State>> readPool;
+
+    /**
+     * A write transaction on `_state`, which must be locked by the
+     * current thread. While it is open, reads made by the same
+     * thread (e.g. `checkInvariants()` calling `isValidPath()` from
+     * `registerValidPaths_()`) use `_state` rather than `readPool`,
+     * so that they see the uncommitted changes.
+     */
+    struct WriteTxn
+    {
+        WriteTxn(LocalStore & store, State & state);
+        ~WriteTxn();
+        void commit();
+
+    private:
+        friend LocalStore;
+        LocalStore & store;
+        State & state;
+        SQLiteTxn txn;
+        WriteTxn * prev;
+        static thread_local WriteTxn * current;
+    };
+
+    /**
+     * Run `fun` on a connection from `readPool` (or on the main
+     * connection if there is no pool), retrying if the database is
+     * busy. If the current thread has an open `WriteTxn`, `fun` runs
+     * on its connection instead.
+     */
+    template<typename T>
+    T retryReadSQLite(std::function<T(State &)> fun);
+
+    /**
+     * A call to `registerValidPaths()` waiting for its paths to be
+     * committed.
+     */
+    struct PendingRegistration
+    {
+        const ValidPathInfos & infos;
+        bool done = false;
+        std::exception_ptr exception;
+    };
+
+    /**
+     * Registrations are committed in groups: while one thread commits
+     * a transaction, other threads queue their registrations, and the
+     * next of them to get its turn commits the whole queue in a single
+     * transaction.
+     */
+    struct GroupCommit
+    {
+        std::vector<PendingRegistration *> queue;
+        bool committing = false;
+    };
+
+    Sync<GroupCommit> _groupCommit;
+    std::condition_variable groupCommitCV;
+
+    void commitRegistrations(const std::vector<PendingRegistration *> & batch);
+
 public:
 
     const Path dbDir;
@@ -168,8 +237,22 @@ public:
     void queryPathInfoUncached(const StorePath & path,
         Callback<std::shared_ptr<const ValidPathInfo>> callback) noexcept override;
 
+    std::map<StorePath, std::shared_ptr<const ValidPathInfo>> queryPathInfosUncached(const StorePathSet & paths) override;
+
     void queryReferrers(const StorePath & path, StorePathSet & referrers) override;
 
+    using Store::computeFSClosure;
+
+    /**
+     * Computes the closure with a single recursive query over the
+     * `Refs` table rather than one query per path. Falls back to the
+     * generic implementation if outputs or derivers are to be
+     * included.
+     */
+    void computeFSClosure(const StorePathSet & paths,
+        StorePathSet & out, bool flipDirection = false,
+        bool includeOutputs = false, bool includeDerivers = false) override;
+
     StorePathSet queryValidDerivers(const StorePath & path) override;
 
     std::map<std::string, std::optional<StorePath>> queryStaticPartialDerivationOutputMap(const StorePath & path) override;
@@ -228,6 +311,36 @@ private:
 
     void findTempRoots(Roots & roots, bool censor);
 
+    /**
+     * What the last complete garbage collection recorded for use by
+     * incremental garbage collection.
+     */
+    struct GCIndex
+    {
+        /**
+         * The roots that were found, including temporary roots.
+         */
+        StorePathSet roots;
+
+        /**
+         * The highest path id when the collection started. Paths with
+         * a higher id have been registered since.
+         */
+        uint64_t maxPathId = 0;
+    };
+
+    /**
+     * @return The recorded GC index, or `std::nullopt` if no complete
+     * garbage collection has been done yet.
+     */
+    std::optional<GCIndex> readGCIndex();
+
+    void writeGCIndex(const GCIndex & index);
+
+    uint64_t queryMaxPathId();
+
+    StorePathSet queryPathsRegisteredAfter(uint64_t pathId);
+
     AutoCloseFD openGCLock();
 
 public:
@@ -356,6 +469,8 @@ private:
 
     void openDB(State & state, bool create);
 
+    void prepareStatements(State & state);
+
     void upgradeDBSchema(State & state);
 
     void makeStoreWritable();
@@ -394,6 +509,7 @@ private:
 
     // Internal versions that are not wrapped in retry_sqlite.
     bool isValidPath_(State & state, const StorePath & path);
+    void registerValidPaths_(State & state, const ValidPathInfos & infos);
     void queryReferrers(State & state, const StorePath & path, StorePathSet & referrers);
 
     /**
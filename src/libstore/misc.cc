@@ -17,45 +17,63 @@ namespace nix {
 void Store::computeFSClosure(const StorePathSet & startPaths,
     StorePathSet & paths_, bool flipDirection, bool includeOutputs, bool includeDerivers)
 {
-    std::function<std::set<StorePath>(const StorePath & path, std::future<ref<const ValidPathInfo>> &)> queryDeps;
-    if (flipDirection)
-        queryDeps = [&](const StorePath& path,
-                        std::future<ref<const ValidPathInfo>> & fut) {
-            StorePathSet res;
-            StorePathSet referrers;
-            queryReferrers(path, referrers);
-            for (auto& ref : referrers)
-                if (ref != path)
-                    res.insert(ref);
-
-            if (includeOutputs)
-                for (auto& i : queryValidDerivers(path))
-                    res.insert(i);
-
-            if (includeDerivers && path.isDerivation())
-                for (auto& [_, maybeOutPath] : queryPartialDerivationOutputMap(path))
-                    if (maybeOutPath && isValidPath(*maybeOutPath))
-                        res.insert(*maybeOutPath);
-            return res;
-        };
-    else
-        queryDeps = [&](const StorePath& path,
-                        std::future<ref<const ValidPathInfo>> & fut) {
-            StorePathSet res;
-            auto info = fut.get();
-            for (auto& ref : info->references)
-                if (ref != path)
-                    res.insert(ref);
-
-            if (includeOutputs && path.isDerivation())
-                for (auto& [_, maybeOutPath] : queryPartialDerivationOutputMap(path))
-                    if (maybeOutPath && isValidPath(*maybeOutPath))
-                        res.insert(*maybeOutPath);
-
-            if (includeDerivers && info->deriver && isValidPath(*info->deriver))
-                res.insert(*info->deriver);
-            return res;
-        };
+    if (!flipDirection) {
+        /* Query the path infos of each level of the closure as a
+           batch, which for remote stores is a single round trip
+           rather than one per path. */
+        StorePathSet frontier;
+        for (auto & path : startPaths)
+            if (paths_.insert(path).second)
+                frontier.insert(path);
+
+        while (!frontier.empty()) {
+            StorePathSet next;
+
+            auto addEdge = [&](const StorePath & path) {
+                if (paths_.insert(path).second)
+                    next.insert(path);
+            };
+
+            for (auto & [path, info] : queryPathInfos(frontier)) {
+                if (!info)
+                    throw InvalidPath("path '%s' is not valid", printStorePath(path));
+
+                for (auto & ref : info->references)
+                    addEdge(ref);
+
+                if (includeOutputs && path.isDerivation())
+                    for (auto & [_, maybeOutPath] : queryPartialDerivationOutputMap(path))
+                        if (maybeOutPath && isValidPath(*maybeOutPath))
+                            addEdge(*maybeOutPath);
+
+                if (includeDerivers && info->deriver && isValidPath(*info->deriver))
+                    addEdge(*info->deriver);
+            }
+
+            frontier = std::move(next);
+        }
+
+        return;
+    }
+
+    auto queryDeps = [&](const StorePath & path) {
+        StorePathSet res;
+        StorePathSet referrers;
+        queryReferrers(path, referrers);
+        for (auto& ref : referrers)
+            if (ref != path)
+                res.insert(ref);
+
+        if (includeOutputs)
+            for (auto& i : queryValidDerivers(path))
+                res.insert(i);
+
+        if (includeDerivers && path.isDerivation())
+            for (auto& [_, maybeOutPath] : queryPartialDerivationOutputMap(path))
+                if (maybeOutPath && isValidPath(*maybeOutPath))
+                    res.insert(*maybeOutPath);
+        return res;
+    };
 
     computeClosure<StorePath>(
         startPaths, paths_,
@@ -67,7 +85,7 @@ void Store::computeFSClosure(const StorePathSet & startPaths,
                 getDependencies =
                     [&](std::future<ref<const ValidPathInfo>> fut) {
                         try {
-                            promise.set_value(queryDeps(path, fut));
+                            promise.set_value(queryDeps(path));
                         } catch (...) {
                             promise.set_exception(std::current_exception());
                         }
@@ -51,6 +51,15 @@ create table if not exists Realisations (
     foreign key (cache) references BinaryCaches(id) on delete cascade
 );
 
+-- Query statistics (see QueryStats), latencies in microseconds
+create table if not exists BinaryCacheStats (
+    cache            integer primary key references BinaryCaches(id) on delete cascade,
+    latencyMean      integer not null,
+    latencyDeviation integer not null,
+    nrQueries        integer not null,
+    nrErrors         integer not null
+);
+
 create table if not exists LastPurge (
     dummy            text primary key,
     value            integer
@@ -81,7 +90,7 @@ public:
         SQLite db;
         SQLiteStmt insertCache, queryCache, insertNAR, insertMissingNAR,
             queryNAR, insertRealisation, insertMissingRealisation,
-            queryRealisation, purgeCache;
+            queryRealisation, purgeCache, queryStats, updateStats;
         std::map<std::string, Cache> caches;
     };
 
@@ -135,6 +144,12 @@ public:
                          (content is not null and timestamp > ?))
             )");
 
+        state->queryStats.create(state->db,
+            "select latencyMean, latencyDeviation, nrQueries, nrErrors from BinaryCacheStats where cache = ?");
+
+        state->updateStats.create(state->db,
+            "insert or replace into BinaryCacheStats(cache, latencyMean, latencyDeviation, nrQueries, nrErrors) values (?, ?, ?, ?, ?)");
+
         /* Periodically purge expired entries from the database. */
         retrySQLite<void>([&]() {
             auto now = time(0);
@@ -237,6 +252,42 @@ public:
         });
     }
 
+    std::pair<Outcome, std::shared_ptr<NarInfo>> lookupNarInfo(
+        State & state, Cache & cache, const std::string & hashPart, time_t now)
+    {
+        auto queryNAR(state.queryNAR.use()
+            (cache.id)
+            (hashPart)
+            (now - settings.ttlNegativeNarInfoCache)
+            (now - settings.ttlPositiveNarInfoCache));
+
+        if (!queryNAR.next())
+            return {oUnknown, 0};
+
+        if (!queryNAR.getInt(0))
+            return {oInvalid, 0};
+
+        auto namePart = queryNAR.getStr(1);
+        auto narInfo = make_ref<NarInfo>(
+            StorePath(hashPart + "-" + namePart),
+            Hash::parseAnyPrefixed(queryNAR.getStr(6)));
+        narInfo->url = queryNAR.getStr(2);
+        narInfo->compression = queryNAR.getStr(3);
+        if (!queryNAR.isNull(4))
+            narInfo->fileHash = Hash::parseAnyPrefixed(queryNAR.getStr(4));
+        narInfo->fileSize = queryNAR.getInt(5);
+        narInfo->narSize = queryNAR.getInt(7);
+        for (auto & r : tokenizeString<Strings>(queryNAR.getStr(8), " "))
+            narInfo->references.insert(StorePath(r));
+        if (!queryNAR.isNull(9))
+            narInfo->deriver = StorePath(queryNAR.getStr(9));
+        for (auto & sig : tokenizeString<Strings>(queryNAR.getStr(10), " "))
+            narInfo->sigs.insert(sig);
+        narInfo->ca = ContentAddress::parseOpt(queryNAR.getStr(11));
+
+        return {oValid, narInfo};
+    }
+
     std::pair<Outcome, std::shared_ptr<NarInfo>> lookupNarInfo(
         const std::string & uri, const std::string & hashPart) override
     {
@@ -246,39 +297,30 @@ public:
 
             auto & cache(getCache(*state, uri));
 
+            return lookupNarInfo(*state, cache, hashPart, time(0));
+        });
+    }
+
+    std::map<std::string, std::pair<Outcome, std::shared_ptr<NarInfo>>> lookupNarInfos(
+        const std::string & uri, const std::set<std::string> & hashParts) override
+    {
+        return retrySQLite<std::map<std::string, std::pair<Outcome, std::shared_ptr<NarInfo>>>>([&]() {
+            auto state(_state.lock());
+
+            auto & cache(getCache(*state, uri));
+
             auto now = time(0);
 
-            auto queryNAR(state->queryNAR.use()
-                (cache.id)
-                (hashPart)
-                (now - settings.ttlNegativeNarInfoCache)
-                (now - settings.ttlPositiveNarInfoCache));
+            std::map<std::string, std::pair<Outcome, std::shared_ptr<NarInfo>>> res;
 
-            if (!queryNAR.next())
-                return {oUnknown, 0};
+            SQLiteTxn txn(state->db);
 
-            if (!queryNAR.getInt(0))
-                return {oInvalid, 0};
+            for (auto & hashPart : hashParts)
+                res.insert_or_assign(hashPart, lookupNarInfo(*state, cache, hashPart, now));
 
-            auto namePart = queryNAR.getStr(1);
-            auto narInfo = make_ref<NarInfo>(
-                StorePath(hashPart + "-" + namePart),
-                Hash::parseAnyPrefixed(queryNAR.getStr(6)));
-            narInfo->url = queryNAR.getStr(2);
-            narInfo->compression = queryNAR.getStr(3);
-            if (!queryNAR.isNull(4))
-                narInfo->fileHash = Hash::parseAnyPrefixed(queryNAR.getStr(4));
-            narInfo->fileSize = queryNAR.getInt(5);
-            narInfo->narSize = queryNAR.getInt(7);
-            for (auto & r : tokenizeString<Strings>(queryNAR.getStr(8), " "))
-                narInfo->references.insert(StorePath(r));
-            if (!queryNAR.isNull(9))
-                narInfo->deriver = StorePath(queryNAR.getStr(9));
-            for (auto & sig : tokenizeString<Strings>(queryNAR.getStr(10), " "))
-                narInfo->sigs.insert(sig);
-            narInfo->ca = ContentAddress::parseOpt(queryNAR.getStr(11));
-
-            return {oValid, narInfo};
+            txn.commit();
+
+            return res;
         });
     }
 
@@ -314,6 +356,40 @@ public:
         });
     }
 
+    void upsertNarInfo(
+        State & state, Cache & cache, const std::string & hashPart,
+        const std::shared_ptr<const ValidPathInfo> & info, time_t now)
+    {
+        if (info) {
+
+            auto narInfo = std::dynamic_pointer_cast<const NarInfo>(info);
+
+            //assert(hashPart == storePathToHash(info->path));
+
+            state.insertNAR.use()
+                (cache.id)
+                (hashPart)
+                (std::string(info->path.name()))
+                (narInfo ? narInfo->url : "", narInfo != 0)
+                (narInfo ? narInfo->compression : "", narInfo != 0)
+                (narInfo && narInfo->fileHash ? narInfo->fileHash->to_string(HashFormat::Nix32, true) : "", narInfo && narInfo->fileHash)
+                (narInfo ? narInfo->fileSize : 0, narInfo != 0 && narInfo->fileSize)
+                (info->narHash.to_string(HashFormat::Nix32, true))
+                (info->narSize)
+                (concatStringsSep(" ", info->shortRefs()))
+                (info->deriver ? std::string(info->deriver->to_string()) : "", (bool) info->deriver)
+                (concatStringsSep(" ", info->sigs))
+                (renderContentAddress(info->ca))
+                (now).exec();
+
+        } else {
+            state.insertMissingNAR.use()
+                (cache.id)
+                (hashPart)
+                (now).exec();
+        }
+    }
+
     void upsertNarInfo(
         const std::string & uri, const std::string & hashPart,
         std::shared_ptr<const ValidPathInfo> info) override
@@ -323,34 +399,27 @@ public:
 
             auto & cache(getCache(*state, uri));
 
-            if (info) {
-
-                auto narInfo = std::dynamic_pointer_cast<const NarInfo>(info);
-
-                //assert(hashPart == storePathToHash(info->path));
-
-                state->insertNAR.use()
-                    (cache.id)
-                    (hashPart)
-                    (std::string(info->path.name()))
-                    (narInfo ? narInfo->url : "", narInfo != 0)
-                    (narInfo ? narInfo->compression : "", narInfo != 0)
-                    (narInfo && narInfo->fileHash ? narInfo->fileHash->to_string(HashFormat::Nix32, true) : "", narInfo && narInfo->fileHash)
-                    (narInfo ? narInfo->fileSize : 0, narInfo != 0 && narInfo->fileSize)
-                    (info->narHash.to_string(HashFormat::Nix32, true))
-                    (info->narSize)
-                    (concatStringsSep(" ", info->shortRefs()))
-                    (info->deriver ? std::string(info->deriver->to_string()) : "", (bool) info->deriver)
-                    (concatStringsSep(" ", info->sigs))
-                    (renderContentAddress(info->ca))
-                    (time(0)).exec();
-
-            } else {
-                state->insertMissingNAR.use()
-                    (cache.id)
-                    (hashPart)
-                    (time(0)).exec();
-            }
+            upsertNarInfo(*state, cache, hashPart, info, time(0));
+        });
+    }
+
+    void upsertNarInfos(
+        const std::string & uri,
+        const std::map<std::string, std::shared_ptr<const ValidPathInfo>> & infos) override
+    {
+        retrySQLite<void>([&]() {
+            auto state(_state.lock());
+
+            auto & cache(getCache(*state, uri));
+
+            auto now = time(0);
+
+            SQLiteTxn txn(state->db);
+
+            for (auto & [hashPart, info] : infos)
+                upsertNarInfo(*state, cache, hashPart, info, now);
+
+            txn.commit();
         });
     }
 
@@ -386,6 +455,45 @@ public:
                 (time(0)).exec();
         });
     }
+
+    std::optional<QueryStats> lookupQueryStats(const std::string & uri) override
+    {
+        return retrySQLite<std::optional<QueryStats>>([&]() -> std::optional<QueryStats> {
+            auto state(_state.lock());
+
+            auto i = state->caches.find(uri);
+            if (i == state->caches.end()) return std::nullopt;
+
+            auto queryStats(state->queryStats.use()(i->second.id));
+
+            if (!queryStats.next())
+                return std::nullopt;
+
+            return QueryStats {
+                .latencyMean = queryStats.getInt(0) / 1000.0,
+                .latencyDeviation = queryStats.getInt(1) / 1000.0,
+                .nrQueries = (uint64_t) queryStats.getInt(2),
+                .nrErrors = (uint64_t) queryStats.getInt(3),
+            };
+        });
+    }
+
+    void upsertQueryStats(const std::string & uri, const QueryStats & stats) override
+    {
+        retrySQLite<void>([&]() {
+            auto state(_state.lock());
+
+            auto i = state->caches.find(uri);
+            if (i == state->caches.end()) return;
+
+            state->updateStats.use()
+                (i->second.id)
+                ((int64_t) (stats.latencyMean * 1000))
+                ((int64_t) (stats.latencyDeviation * 1000))
+                ((int64_t) stats.nrQueries)
+                ((int64_t) stats.nrErrors).exec();
+        });
+    }
 };
 
 ref<NarInfoDiskCache> getNarInfoDiskCache()
@@ -4,6 +4,7 @@
 #include "ref.hh"
 #include "nar-info.hh"
 #include "realisation.hh"
+#include "query-stats.hh"
 
 namespace nix {
 
@@ -29,10 +30,25 @@ public:
     virtual std::pair<Outcome, std::shared_ptr<NarInfo>> lookupNarInfo(
         const std::string & uri, const std::string & hashPart) = 0;
 
+    /**
+     * Like `lookupNarInfo()`, but for several hash parts at once, in
+     * a single transaction.
+     */
+    virtual std::map<std::string, std::pair<Outcome, std::shared_ptr<NarInfo>>> lookupNarInfos(
+        const std::string & uri, const std::set<std::string> & hashParts) = 0;
+
     virtual void upsertNarInfo(
         const std::string & uri, const std::string & hashPart,
         std::shared_ptr<const ValidPathInfo> info) = 0;
 
+    /**
+     * Like `upsertNarInfo()`, but for several hash parts at once, in
+     * a single transaction. A null info records the path as missing.
+     */
+    virtual void upsertNarInfos(
+        const std::string & uri,
+        const std::map<std::string, std::shared_ptr<const ValidPathInfo>> & infos) = 0;
+
     virtual void upsertRealisation(
         const std::string & uri,
         const Realisation & realisation) = 0;
@@ -41,6 +57,14 @@ public:
         const DrvOutput & id) = 0;
     virtual std::pair<Outcome, std::shared_ptr<Realisation>> lookupRealisation(
         const std::string & uri, const DrvOutput & id) = 0;
+
+    /**
+     * Return the query statistics recorded for the binary cache
+     * `uri`, if any.
+     */
+    virtual std::optional<QueryStats> lookupQueryStats(const std::string & uri) = 0;
+
+    virtual void upsertQueryStats(const std::string & uri, const QueryStats & stats) = 0;
 };
 
 /**
@@ -0,0 +1,50 @@
+#include "query-stats.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nix {
+
+void QueryStats::record(std::chrono::duration<double, std::milli> latency, bool error)
+{
+    if (nrQueries >= window) {
+        nrQueries /= 2;
+        nrErrors /= 2;
+    }
+
+    nrQueries++;
+
+    if (error) {
+        nrErrors++;
+        return;
+    }
+
+    auto ms = latency.count();
+
+    if (latencyMean == 0 && latencyDeviation == 0) {
+        latencyMean = ms;
+        latencyDeviation = ms / 2;
+    } else {
+        latencyDeviation += (std::fabs(ms - latencyMean) - latencyDeviation) / 4;
+        latencyMean += (ms - latencyMean) / 8;
+    }
+}
+
+std::chrono::milliseconds QueryStats::hedgeDelay() const
+{
+    using namespace std::chrono_literals;
+
+    if (nrErrors * 2 > nrQueries)
+        return 0ms;
+
+    /* Without enough samples, be patient. */
+    if (nrQueries - nrErrors < minQueries)
+        return 1000ms;
+
+    return std::clamp(
+        std::chrono::milliseconds(std::llround(latencyMean + 4 * latencyDeviation)),
+        std::chrono::milliseconds(10ms),
+        std::chrono::milliseconds(10000ms));
+}
+
+}
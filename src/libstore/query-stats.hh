@@ -0,0 +1,58 @@
+#pragma once
+///@file
+
+#include <chrono>
+#include <cstdint>
+
+namespace nix {
+
+/**
+ * Latency and error statistics of the path info queries sent to a
+ * store, used to decide when to ask the next substituter instead of
+ * waiting for a slow one.
+ *
+ * Latencies are smoothed in the same way as TCP round-trip times
+ * (RFC 6298), so `latencyMean + 4 * latencyDeviation` is an estimate
+ * of a high percentile of the latency.
+ */
+struct QueryStats
+{
+    /**
+     * Smoothed latency of successful queries, in milliseconds.
+     */
+    double latencyMean = 0;
+
+    /**
+     * Smoothed mean deviation of `latencyMean`, in milliseconds.
+     */
+    double latencyDeviation = 0;
+
+    /**
+     * The number of recent queries, and how many of those failed.
+     * Both are halved whenever `nrQueries` reaches `window`, so old
+     * failures are eventually forgotten.
+     */
+    uint64_t nrQueries = 0;
+    uint64_t nrErrors = 0;
+
+    static constexpr uint64_t window = 64;
+
+    /**
+     * The number of queries needed before the latency estimate is
+     * trusted.
+     */
+    static constexpr uint64_t minQueries = 8;
+
+    void record(std::chrono::duration<double, std::milli> latency, bool error);
+
+    /**
+     * How long to wait for an answer from this store before also
+     * asking the next one. This is zero if most recent queries
+     * failed.
+     */
+    std::chrono::milliseconds hedgeDelay() const;
+
+    bool operator == (const QueryStats &) const = default;
+};
+
+}
@@ -33,9 +33,12 @@ std::set<Realisation> Realisation::closure(Store & store, const std::set<Realisa
 void Realisation::closure(Store & store, const std::set<Realisation> & startOutputs, std::set<Realisation> & res)
 {
     auto getDeps = [&](const Realisation& current) -> std::set<Realisation> {
+        std::set<DrvOutput> ids;
+        for (auto& [currentDep, _] : current.dependentRealisations)
+            ids.insert(currentDep);
         std::set<Realisation> res;
-        for (auto& [currentDep, _] : current.dependentRealisations) {
-            if (auto currentRealisation = store.queryRealisation(currentDep))
+        for (auto& [currentDep, currentRealisation] : store.queryRealisations(ids)) {
+            if (currentRealisation)
                 res.insert(*currentRealisation);
             else
                 throw Error(
@@ -1,6 +1,7 @@
 #include <nlohmann/json.hpp>
 #include "remote-fs-accessor.hh"
 #include "nar-accessor.hh"
+#include "binary-cache-store.hh"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -100,6 +101,15 @@ std::pair<ref<SourceAccessor>, CanonPath> RemoteFSAccessor::fetch(const CanonPat
         } catch (SystemError &) { }
     }
 
+    /* If the binary cache can serve parts of the NAR, don't download
+       all of it. */
+    if (auto binaryCacheStore = dynamic_cast<BinaryCacheStore *>(&*store)) {
+        if (auto narAccessor = binaryCacheStore->getSeekableNarAccessor(storePath)) {
+            nars.emplace(storePath.hashPart(), ref(narAccessor));
+            return {ref(narAccessor), restPath};
+        }
+    }
+
     StringSink sink;
     store->narFromPath(storePath, sink);
     return {addToCache(storePath.hashPart(), std::move(sink.s)), restPath};
@@ -287,6 +287,30 @@ void RemoteStore::queryPathInfoUncached(const StorePath & path,
 }
 
 
+std::map<StorePath, std::shared_ptr<const ValidPathInfo>> RemoteStore::queryPathInfosUncached(const StorePathSet & paths)
+{
+    {
+        auto conn(getConnection());
+        if (conn->features.count(WorkerProto::featureBatchedQueries)) {
+            /* The daemon returns the infos of the valid paths only,
+               keyed by their actual path, which may differ in name
+               from the requested one (see `Store::MissingName`). */
+            std::map<std::string, std::shared_ptr<const ValidPathInfo>> byHashPart;
+            for (auto & info : conn->queryPathInfos(*this, &conn.daemonException, paths))
+                byHashPart.insert_or_assign(std::string(info.path.hashPart()), std::make_shared<const ValidPathInfo>(std::move(info)));
+            std::map<StorePath, std::shared_ptr<const ValidPathInfo>> infos;
+            for (auto & path : paths) {
+                auto i = byHashPart.find(std::string(path.hashPart()));
+                infos.insert_or_assign(path, i == byHashPart.end() ? nullptr : i->second);
+            }
+            return infos;
+        }
+    }
+
+    return Store::queryPathInfosUncached(paths);
+}
+
+
 void RemoteStore::queryReferrers(const StorePath & path,
     StorePathSet & referrers)
 {
@@ -622,6 +646,26 @@ void RemoteStore::queryRealisationUncached(const DrvOutput & id,
     } catch (...) { return callback.rethrow(); }
 }
 
+std::map<DrvOutput, std::shared_ptr<const Realisation>> RemoteStore::queryRealisations(const std::set<DrvOutput> & ids)
+{
+    {
+        auto conn(getConnection());
+        if (conn->features.count(WorkerProto::featureBatchedQueries)) {
+            conn->to << WorkerProto::Op::QueryRealisations;
+            WorkerProto::write(*this, *conn, ids);
+            conn.processStderr();
+            std::map<DrvOutput, std::shared_ptr<const Realisation>> res;
+            for (auto & id : ids)
+                res.insert_or_assign(id, nullptr);
+            for (auto & realisation : WorkerProto::Serialise<std::set<Realisation>>::read(*this, *conn))
+                res.insert_or_assign(realisation.id, std::make_shared<const Realisation>(realisation));
+            return res;
+        }
+    }
+
+    return Store::queryRealisations(ids);
+}
+
 void RemoteStore::copyDrvsFromEvalStore(
     const std::vector<DerivedPath> & paths,
     std::shared_ptr<Store> evalStore)
@@ -798,8 +842,10 @@ void RemoteStore::collectGarbage(const GCOptions & options, GCResults & results)
     WorkerProto::write(*this, *conn, options.pathsToDelete);
     conn->to << options.ignoreLiveness
         << options.maxFreed
+        /* Older daemons ignore this and do a full collection. */
+        << options.incremental
         /* removed options */
-        << 0 << 0 << 0;
+        << 0 << 0;
 
     conn.processStderr();
 
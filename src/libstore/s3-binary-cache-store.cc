@@ -327,6 +327,9 @@ struct S3BinaryCacheStoreImpl : virtual S3BinaryCacheStoreConfig, public virtual
 
                 transferConfig.s3Client = s3Helper.client;
                 transferConfig.bufferSize = bufferSize;
+                /* This bounds the number of parts in flight; the SDK's
+                   default only allows two parts of 5 MiB. */
+                transferConfig.transferBufferMaxHeapSize = std::max<uint64_t>(multipartUploadMemory, bufferSize);
 
                 transferConfig.uploadProgressCallback =
                     [](const TransferManager *transferManager,
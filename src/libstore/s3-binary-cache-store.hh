@@ -89,6 +89,17 @@ public:
     const Setting<uint64_t> bufferSize{
         this, 5 * 1024 * 1024, "buffer-size", "Size (in bytes) of each part in multi-part uploads."};
 
+    const Setting<uint64_t> multipartUploadMemory{
+        this,
+        64 * 1024 * 1024,
+        "multipart-upload-memory",
+        R"(
+          The maximum amount of memory (in bytes) used to buffer the parts
+          of multi-part uploads. Parts are uploaded concurrently, so up to
+          `multipart-upload-memory / buffer-size` parts are in flight at
+          the same time.
+        )"};
+
     const std::string name() override
     {
         return "S3 Binary Cache Store";
@@ -22,6 +22,13 @@ enum class SQLiteOpenMode {
      * Fails with an error if the database does not exist.
      */
     NoCreate,
+    /**
+     * Open the database in read-only mode, e.g. because it belongs
+     * to another user. Unlike `Immutable`, this still sees writes by
+     * other processes.
+     * Fails with an error if the database does not exist.
+     */
+    ReadOnly,
     /**
      * Open the database in immutable mode.
      * In addition to the database being read-only,
@@ -11,6 +11,7 @@
 #include "references.hh"
 #include "archive.hh"
 #include "callback.hh"
+#include "finally.hh"
 #include "git.hh"
 #include "posix-source-accessor.hh"
 // FIXME this should not be here, see TODO below on
@@ -442,6 +443,16 @@ Store::Store(const Params & params)
 }
 
 
+Store::~Store()
+{
+    try {
+        writeQueryStats(true);
+    } catch (...) {
+        ignoreExceptionInDestructor();
+    }
+}
+
+
 std::string Store::getUri()
 {
     return "";
@@ -516,45 +527,148 @@ StorePathSet Store::queryDerivationOutputs(const StorePath & path)
 }
 
 
+/**
+ * The maximum number of concurrent queries issued by
+ * queryPathInfos() and querySubstitutablePathInfos(). For binary
+ * caches, these are HTTP requests that are multiplexed over
+ * `http-connections` connections.
+ */
+static const size_t maxPathInfoQueriesInFlight = 256;
+
+
 void Store::querySubstitutablePathInfos(const StorePathCAMap & paths, SubstitutablePathInfos & infos)
 {
     if (!settings.useSubstitutes) return;
-    for (auto & sub : getDefaultSubstituters()) {
-        for (auto & path : paths) {
-            if (infos.count(path.first))
-                // Choose first succeeding substituter.
-                continue;
 
-            auto subPath(path.first);
+    auto subs_ = getDefaultSubstituters();
+    std::vector<ref<Store>> subs(subs_.begin(), subs_.end());
+    if (subs.empty()) return;
+
+    /* What a substituter said about a path. */
+    enum Answer { Inapplicable, Unasked, Pending, Absent, Present };
+
+    struct Query
+    {
+        StorePath path;
+        /* The path to ask each substituter about, or `std::nullopt`
+           if the substituter can't provide `path`. */
+        std::vector<std::optional<StorePath>> subPaths;
+        std::vector<Answer> answers;
+        std::vector<std::shared_ptr<const ValidPathInfo>> infos;
+        /* The substituter that was asked last, and when to ask the
+           next one if it hasn't answered by then. */
+        std::optional<size_t> last;
+        std::chrono::steady_clock::time_point deadline;
+        std::optional<size_t> winner;
+        bool done = false;
+    };
+
+    /* A query to be issued to a substituter. */
+    struct Due
+    {
+        size_t query;
+        size_t sub;
+        StorePath subPath;
+    };
+
+    struct State
+    {
+        std::vector<Query> queries;
+        size_t inFlight = 0;
+        /* The first error returned by each substituter. */
+        std::vector<std::exception_ptr> errors;
+        /* Queries not yet picked up by a query thread. */
+        std::queue<Due> toQuery;
+        size_t nrQueryThreads = 0, busyQueryThreads = 0;
+    };
+
+    /* If an asynchronous substituter is slow, we may return before it
+       answers, so its callbacks share ownership of the state. */
+    struct Shared
+    {
+        Sync<State> state;
+        std::condition_variable wakeup;
+        std::atomic<bool> quit{false};
+    };
+
+    auto shared = std::make_shared<Shared>();
+
+    {
+        auto state(shared->state.lock());
+
+        state->errors.resize(subs.size());
+
+        for (auto & [path, ca] : paths) {
+            if (infos.count(path)) continue;
 
             // Recompute store path so that we can use a different store root.
-            if (path.second) {
-                subPath = makeFixedOutputPathFromCA(
-                    path.first.name(),
-                    ContentAddressWithReferences::withoutRefs(*path.second));
-                if (sub->storeDir == storeDir)
-                    assert(subPath == path.first);
-                if (subPath != path.first)
-                    debug("replaced path '%s' with '%s' for substituter '%s'", printStorePath(path.first), sub->printStorePath(subPath), sub->getUri());
-            } else if (sub->storeDir != storeDir) continue;
-
-            debug("checking substituter '%s' for path '%s'", sub->getUri(), sub->printStorePath(subPath));
-            try {
-                auto info = sub->queryPathInfo(subPath);
+            auto caPath = ca
+                ? makeFixedOutputPathFromCA(path.name(), ContentAddressWithReferences::withoutRefs(*ca))
+                : path;
+
+            Query query{.path = path};
+
+            for (auto & sub : subs) {
+                std::optional<StorePath> subPath;
+                if (ca) {
+                    if (sub->storeDir == storeDir)
+                        assert(caPath == path);
+                    if (caPath != path)
+                        debug("replaced path '%s' with '%s' for substituter '%s'", printStorePath(path), sub->printStorePath(caPath), sub->getUri());
+                    subPath = caPath;
+                } else if (sub->storeDir == storeDir)
+                    subPath = path;
+                query.answers.push_back(subPath ? Unasked : Inapplicable);
+                query.subPaths.push_back(std::move(subPath));
+            }
+
+            query.infos.resize(subs.size());
+            state->queries.push_back(std::move(query));
+        }
+    }
+
+    /* Whether a substituter can be used for `path` (as opposed to
+       only knowing about it). */
+    auto usable = [subs, storeDir{storeDir}](size_t n, const ValidPathInfo & info) {
+        return subs[n]->storeDir == storeDir || (info.isContentAddressed(*subs[n]) && info.references.empty());
+    };
 
-                if (sub->storeDir != storeDir && !(info->isContentAddressed(*sub) && info->references.empty()))
+    /* Pick the substituter to use for `q` if possible. The first
+       substituter that has the path is preferred, but a substituter
+       that hasn't answered before its deadline is skipped if a later
+       one has the path. */
+    auto decide = [&](Query & q) {
+        bool waiting = false;
+        for (size_t n = 0; n < subs.size(); ++n) {
+            switch (q.answers[n]) {
+            case Inapplicable:
+            case Absent:
+                continue;
+            case Present:
+                q.winner = n;
+                q.done = true;
+                return;
+            case Pending:
+                if (q.last && *q.last > n) {
+                    waiting = true;
                     continue;
+                }
+                return;
+            case Unasked:
+                return;
+            }
+        }
+        q.done = !waiting;
+    };
 
-                auto narInfo = std::dynamic_pointer_cast<const NarInfo>(
-                    std::shared_ptr<const ValidPathInfo>(info));
-                infos.insert_or_assign(path.first, SubstitutablePathInfo{
-                    .deriver = info->deriver,
-                    .references = info->references,
-                    .downloadSize = narInfo ? narInfo->fileSize : 0,
-                    .narSize = info->narSize,
-                });
-            } catch (InvalidPath &) {
-            } catch (SubstituterDisabled &) {
+    std::vector<bool> errorShown(subs.size(), false);
+
+    auto handleErrors = [&](State & state) {
+        for (size_t n = 0; n < subs.size(); ++n) {
+            if (!state.errors[n] || errorShown[n]) continue;
+            errorShown[n] = true;
+            try {
+                std::rethrow_exception(state.errors[n]);
             } catch (Error & e) {
                 if (settings.tryFallback)
                     logError(e.info());
@@ -562,6 +676,189 @@ void Store::querySubstitutablePathInfos(const StorePathCAMap & paths, Substituta
                     throw;
             }
         }
+    };
+
+    /* Answer as much as possible from the substituters' local
+       narinfo caches. */
+    for (size_t n = 0; n < subs.size(); ++n) {
+        auto state(shared->state.lock());
+
+        std::map<StorePath, size_t> subPaths;
+        for (size_t i = 0; i < state->queries.size(); ++i) {
+            auto & q = state->queries[i];
+            if (!q.done && q.answers[n] == Unasked)
+                subPaths.insert_or_assign(*q.subPaths[n], i);
+        }
+
+        if (!subPaths.empty()) {
+            StorePathSet query;
+            for (auto & [subPath, _] : subPaths)
+                query.insert(subPath);
+
+            try {
+                for (auto & [subPath, info] : subs[n]->queryPathInfosFromClientCache(query)) {
+                    auto & q = state->queries[subPaths.at(subPath)];
+                    q.answers[n] = info && usable(n, *info) ? Present : Absent;
+                    q.infos[n] = info;
+                }
+            } catch (SubstituterDisabled &) {
+            } catch (...) {
+                state->errors[n] = std::current_exception();
+                handleErrors(*state);
+            }
+        }
+
+        for (auto & q : state->queries)
+            if (!q.done) decide(q);
+    }
+
+    std::vector<std::chrono::milliseconds> hedgeDelays;
+    for (auto & sub : subs)
+        hedgeDelays.push_back(sub->getQueryStats().hedgeDelay());
+
+    /* queryPathInfo() is asynchronous for some stores (e.g. HTTP
+       binary caches) and synchronous for others, so the queries are
+       issued by query threads. These are started as needed and
+       joined before we return. Synchronous queries that are still
+       running at that point are interrupted. */
+    auto maxQueryThreads = std::max(1U, std::thread::hardware_concurrency());
+
+    auto queryThread = [shared, subs, usable]() {
+        ReceiveInterrupts receiveInterrupts;
+
+#ifndef _WIN32
+        unix::interruptCheck = [&]() { return (bool) shared->quit; };
+#endif
+
+        while (true) {
+            std::optional<Due> due;
+            {
+                auto state(shared->state.lock());
+                while (state->toQuery.empty() && !shared->quit)
+                    state.wait(shared->wakeup);
+                if (shared->quit) {
+                    state->nrQueryThreads--;
+                    return;
+                }
+                due = std::move(state->toQuery.front());
+                state->toQuery.pop();
+                state->busyQueryThreads++;
+            }
+
+            auto & sub = subs[due->sub];
+
+            debug("checking substituter '%s' for path '%s'", sub->getUri(), sub->printStorePath(due->subPath));
+
+            sub->queryPathInfo(due->subPath, {[shared, d{*due}, usable](std::future<ref<const ValidPathInfo>> fut) {
+                std::shared_ptr<const ValidPathInfo> info;
+                std::exception_ptr exc;
+
+                try {
+                    info = fut.get().get_ptr();
+                } catch (InvalidPath &) {
+                } catch (SubstituterDisabled &) {
+                } catch (...) {
+                    exc = std::current_exception();
+                }
+
+                auto state(shared->state.lock());
+                auto & q = state->queries[d.query];
+                q.answers[d.sub] = info && usable(d.sub, *info) ? Present : Absent;
+                q.infos[d.sub] = info;
+                if (exc && !state->errors[d.sub])
+                    state->errors[d.sub] = exc;
+                state->inFlight--;
+                shared->wakeup.notify_all();
+            }});
+
+            shared->state.lock()->busyQueryThreads--;
+        }
+    };
+
+    std::vector<std::thread> queryThreads;
+
+    Finally stopQueryThreads([&]() {
+        shared->quit = true;
+        shared->wakeup.notify_all();
+        for (auto & thread : queryThreads)
+            thread.join();
+    });
+
+    /* Ask the substituters in order of priority. If a substituter
+       doesn't answer within its hedge delay, ask the next one as well
+       rather than waiting. */
+    while (true) {
+        checkInterrupt();
+
+        auto state(shared->state.lock());
+
+        handleErrors(*state);
+
+        auto now = std::chrono::steady_clock::now();
+        auto nextDeadline = std::chrono::steady_clock::time_point::max();
+        size_t left = 0;
+
+        for (size_t i = 0; i < state->queries.size(); ++i) {
+            auto & q = state->queries[i];
+            if (q.done) continue;
+            decide(q);
+            if (q.done) continue;
+            left++;
+
+            auto next = q.last ? *q.last + 1 : 0;
+            while (next < subs.size() && q.answers[next] != Unasked) next++;
+            if (next == subs.size()) continue;
+
+            if (q.last && q.answers[*q.last] == Pending && now < q.deadline) {
+                nextDeadline = std::min(nextDeadline, q.deadline);
+                continue;
+            }
+
+            if (state->inFlight >= maxPathInfoQueriesInFlight) continue;
+
+            q.answers[next] = Pending;
+            q.last = next;
+            q.deadline = now + hedgeDelays[next];
+            nextDeadline = std::min(nextDeadline, q.deadline);
+            state->inFlight++;
+            state->toQuery.push({i, next, *q.subPaths[next]});
+        }
+
+        if (!left) {
+            for (auto & q : state->queries) {
+                if (!q.winner) continue;
+                auto & info = q.infos[*q.winner];
+                auto narInfo = std::dynamic_pointer_cast<const NarInfo>(info);
+                infos.insert_or_assign(q.path, SubstitutablePathInfo{
+                    .deriver = info->deriver,
+                    .references = info->references,
+                    .downloadSize = narInfo ? narInfo->fileSize : 0,
+                    .narSize = info->narSize,
+                });
+            }
+            break;
+        }
+
+        while (state->nrQueryThreads < maxQueryThreads
+            && state->nrQueryThreads < state->busyQueryThreads + state->toQuery.size())
+        {
+            queryThreads.emplace_back(queryThread);
+            state->nrQueryThreads++;
+        }
+        shared->wakeup.notify_all();
+
+        if (nextDeadline == std::chrono::steady_clock::time_point::max())
+            state.wait(shared->wakeup);
+        else
+            state.wait_until(shared->wakeup, nextDeadline);
+    }
+
+    for (auto & sub : subs) {
+        try {
+            sub->saveQueryStats();
+        } catch (...) {
+            ignoreExceptionExceptInterrupt();
+        }
     }
 }
 
@@ -690,11 +987,22 @@ void Store::queryPathInfo(const StorePath & storePath,
 
     auto callbackPtr = std::make_shared<decltype(callback)>(std::move(callback));
 
+    auto start = std::chrono::steady_clock::now();
+
     queryPathInfoUncached(storePath,
-        {[this, storePath, hashPart, callbackPtr](std::future<std::shared_ptr<const ValidPathInfo>> fut) {
+        {[this, storePath, hashPart, callbackPtr, start](std::future<std::shared_ptr<const ValidPathInfo>> fut) {
 
             try {
-                auto info = fut.get();
+                std::shared_ptr<const ValidPathInfo> info;
+
+                try {
+                    info = fut.get();
+                } catch (...) {
+                    recordQuery(start, true);
+                    throw;
+                }
+
+                recordQuery(start, false);
 
                 if (diskCache)
                     diskCache->upsertNarInfo(getUri(), hashPart, info);
@@ -714,6 +1022,166 @@ void Store::queryPathInfo(const StorePath & storePath,
         }});
 }
 
+std::map<StorePath, std::shared_ptr<const ValidPathInfo>> Store::queryPathInfosFromClientCache(const StorePathSet & paths)
+{
+    std::map<StorePath, std::shared_ptr<const ValidPathInfo>> infos;
+    StorePathSet missing;
+
+    {
+        auto state_(state.lock());
+        for (auto & path : paths) {
+            auto res = state_->pathInfoCache.get(std::string(path.to_string()));
+            if (res && res->isKnownNow()) {
+                stats.narInfoReadAverted++;
+                infos.insert_or_assign(path, res->didExist() ? res->value : nullptr);
+            } else
+                missing.insert(path);
+        }
+    }
+
+    if (diskCache && !missing.empty()) {
+        std::set<std::string> hashParts;
+        for (auto & path : missing)
+            hashParts.insert(std::string(path.hashPart()));
+
+        auto cached = diskCache->lookupNarInfos(getUri(), hashParts);
+
+        auto state_(state.lock());
+        for (auto i = missing.begin(); i != missing.end(); ) {
+            auto & [outcome, info] = cached.at(std::string(i->hashPart()));
+            if (outcome == NarInfoDiskCache::oUnknown) {
+                ++i;
+                continue;
+            }
+            stats.narInfoReadAverted++;
+            state_->pathInfoCache.upsert(std::string(i->to_string()),
+                outcome == NarInfoDiskCache::oInvalid ? PathInfoCacheValue{} : PathInfoCacheValue{ .value = info });
+            infos.insert_or_assign(*i,
+                outcome == NarInfoDiskCache::oValid && goodStorePath(*i, info->path) ? info : nullptr);
+            i = missing.erase(i);
+        }
+    }
+
+    return infos;
+}
+
+std::map<StorePath, std::shared_ptr<const ValidPathInfo>> Store::queryPathInfos(const StorePathSet & paths)
+{
+    auto infos = queryPathInfosFromClientCache(paths);
+
+    StorePathSet missing;
+    for (auto & path : paths)
+        if (!infos.count(path))
+            missing.insert(path);
+
+    if (missing.empty()) return infos;
+
+    auto fetched = queryPathInfosUncached(missing);
+
+    if (diskCache) {
+        std::map<std::string, std::shared_ptr<const ValidPathInfo>> toCache;
+        for (auto & path : missing) {
+            auto i = fetched.find(path);
+            toCache.insert_or_assign(std::string(path.hashPart()), i == fetched.end() ? nullptr : i->second);
+        }
+        diskCache->upsertNarInfos(getUri(), toCache);
+    }
+
+    for (auto & path : missing) {
+        auto i = fetched.find(path);
+        std::shared_ptr<const ValidPathInfo> info = i == fetched.end() ? nullptr : i->second;
+
+        {
+            auto state_(state.lock());
+            state_->pathInfoCache.upsert(std::string(path.to_string()), PathInfoCacheValue { .value = info });
+        }
+
+        if (!info || !goodStorePath(path, info->path)) {
+            stats.narInfoMissing++;
+            info = nullptr;
+        }
+
+        infos.insert_or_assign(path, info);
+    }
+
+    return infos;
+}
+
+
+std::map<StorePath, std::shared_ptr<const ValidPathInfo>> Store::queryPathInfosUncached(const StorePathSet & paths)
+{
+    struct State
+    {
+        size_t left;
+        size_t inFlight = 0;
+        std::map<StorePath, std::shared_ptr<const ValidPathInfo>> infos;
+        std::exception_ptr exc;
+    };
+
+    Sync<State> state_(State{.left = paths.size()});
+
+    std::condition_variable wakeup;
+
+    /* queryPathInfoUncached() is asynchronous for some stores
+       (e.g. HTTP binary caches) and synchronous for others, so issue
+       the queries from a thread pool. */
+    ThreadPool pool;
+
+    auto doQuery = [&](const StorePath & path) {
+        checkInterrupt();
+
+        {
+            auto state(state_.lock());
+            while (state->inFlight >= maxPathInfoQueriesInFlight)
+                state.wait(wakeup);
+            state->inFlight++;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        queryPathInfoUncached(path, {[this, path, start, &state_, &wakeup](std::future<std::shared_ptr<const ValidPathInfo>> fut) {
+            std::shared_ptr<const ValidPathInfo> info;
+            std::exception_ptr newExc{};
+
+            try {
+                info = fut.get();
+                recordQuery(start, false);
+            } catch (InvalidPath &) {
+                recordQuery(start, false);
+            } catch (...) {
+                recordQuery(start, true);
+                newExc = std::current_exception();
+            }
+
+            auto state(state_.lock());
+
+            state->infos.insert_or_assign(path, info);
+
+            if (newExc && !state->exc)
+                state->exc = newExc;
+
+            assert(state->left && state->inFlight);
+            state->left--;
+            state->inFlight--;
+            wakeup.notify_all();
+        }});
+    };
+
+    for (auto & path : paths)
+        pool.enqueue(std::bind(doQuery, path));
+
+    pool.process();
+
+    while (true) {
+        auto state(state_.lock());
+        if (!state->left) {
+            if (state->exc) std::rethrow_exception(state->exc);
+            return std::move(state->infos);
+        }
+        state.wait(wakeup);
+    }
+}
+
 void Store::queryRealisation(const DrvOutput & id,
         Callback<std::shared_ptr<const Realisation>> callback) noexcept
 {
@@ -783,6 +1251,14 @@ std::shared_ptr<const Realisation> Store::queryRealisation(const DrvOutput & id)
     return promise.get_future().get();
 }
 
+std::map<DrvOutput, std::shared_ptr<const Realisation>> Store::queryRealisations(const std::set<DrvOutput> & ids)
+{
+    std::map<DrvOutput, std::shared_ptr<const Realisation>> res;
+    for (auto & id : ids)
+        res.insert_or_assign(id, queryRealisation(id));
+    return res;
+}
+
 void Store::substitutePaths(const StorePathSet & paths)
 {
     std::vector<DerivedPath> paths2;
@@ -807,59 +1283,13 @@ void Store::substitutePaths(const StorePathSet & paths)
 
 StorePathSet Store::queryValidPaths(const StorePathSet & paths, SubstituteFlag maybeSubstitute)
 {
-    struct State
-    {
-        size_t left;
-        StorePathSet valid;
-        std::exception_ptr exc;
-    };
-
-    Sync<State> state_(State{paths.size(), StorePathSet()});
+    StorePathSet valid;
 
-    std::condition_variable wakeup;
-    ThreadPool pool;
+    for (auto & [path, info] : queryPathInfos(paths))
+        if (info)
+            valid.insert(path);
 
-    auto doQuery = [&](const StorePath & path) {
-        checkInterrupt();
-        queryPathInfo(path, {[path, &state_, &wakeup](std::future<ref<const ValidPathInfo>> fut) {
-            bool exists = false;
-            std::exception_ptr newExc{};
-
-            try {
-                auto info = fut.get();
-                exists = true;
-            } catch (InvalidPath &) {
-            } catch (...) {
-                newExc = std::current_exception();
-            }
-
-            auto state(state_.lock());
-
-            if (exists)
-                state->valid.insert(path);
-
-            if (newExc)
-                state->exc = newExc;
-
-            assert(state->left);
-            if (!--state->left)
-                wakeup.notify_one();
-        }});
-    };
-
-    for (auto & path : paths)
-        pool.enqueue(std::bind(doQuery, path));
-
-    pool.process();
-
-    while (true) {
-        auto state(state_.lock());
-        if (!state->left) {
-            if (state->exc) std::rethrow_exception(state->exc);
-            return std::move(state->valid);
-        }
-        state.wait(wakeup);
-    }
+    return valid;
 }
 
 
@@ -940,6 +1370,68 @@ const Store::Stats & Store::getStats()
 }
 
 
+QueryStats & Store::loadQueryStats(QueryStatsState & state)
+{
+    if (!state.stats) {
+        state.stats = QueryStats{};
+        state.uri = getUri();
+        if (diskCache) {
+            try {
+                state.saved = diskCache->lookupQueryStats(state.uri);
+                if (state.saved)
+                    state.stats = *state.saved;
+            } catch (...) {
+                ignoreExceptionExceptInterrupt();
+            }
+        }
+    }
+    return *state.stats;
+}
+
+
+QueryStats Store::getQueryStats()
+{
+    auto queryStats_(queryStats.lock());
+    return loadQueryStats(*queryStats_);
+}
+
+
+void Store::recordQuery(std::chrono::steady_clock::time_point start, bool error)
+{
+    auto latency = std::chrono::steady_clock::now() - start;
+    auto queryStats_(queryStats.lock());
+    loadQueryStats(*queryStats_).record(latency, error);
+}
+
+
+void Store::saveQueryStats()
+{
+    writeQueryStats(false);
+}
+
+
+void Store::writeQueryStats(bool force)
+{
+    if (!diskCache) return;
+
+    std::string uri;
+    QueryStats stats;
+
+    {
+        auto queryStats_(queryStats.lock());
+        if (!queryStats_->stats || queryStats_->stats == queryStats_->saved) return;
+        auto now = std::chrono::steady_clock::now();
+        if (!force && queryStats_->saved && now < queryStats_->lastSave + std::chrono::minutes(1)) return;
+        uri = queryStats_->uri;
+        stats = *queryStats_->stats;
+        queryStats_->saved = stats;
+        queryStats_->lastSave = now;
+    }
+
+    diskCache->upsertQueryStats(uri, stats);
+}
+
+
 static std::string makeCopyPathMessage(
     std::string_view srcUri,
     std::string_view dstUri,
@@ -994,7 +1486,10 @@ void copyStorePath(
         info = info2;
     }
 
-    auto source = sinkToSource([&](Sink & sink) {
+    /* Fetch (and decompress) the NAR in a separate thread, so that
+       it overlaps with unpacking and hashing it in dstStore. */
+    auto source = sinkToSourceThreaded([&](Sink & sink) {
+        PushActivity pact(act.id);
         LambdaSink progressSink([&](std::string_view data) {
             total += data.size();
             act.progress(total, info->narSize);
@@ -15,6 +15,7 @@
 #include "store-dir-config.hh"
 #include "store-reference.hh"
 #include "source-path.hh"
+#include "query-stats.hh"
 
 #include <nlohmann/json_fwd.hpp>
 #include <atomic>
@@ -205,6 +206,25 @@ protected:
 
     std::shared_ptr<NarInfoDiskCache> diskCache;
 
+    struct QueryStatsState
+    {
+        /**
+         * Statistics of the queries made by queryPathInfo() to the
+         * underlying store. Loaded lazily from the narinfo disk cache.
+         */
+        std::optional<QueryStats> stats;
+
+        /**
+         * The URI the statistics are kept under, and the statistics
+         * last written to the narinfo disk cache.
+         */
+        std::string uri;
+        std::optional<QueryStats> saved;
+        std::chrono::steady_clock::time_point lastSave;
+    };
+
+    Sync<QueryStatsState> queryStats;
+
     Store(const Params & params);
 
 public:
@@ -214,7 +234,7 @@ public:
      */
     virtual void init() {};
 
-    virtual ~Store() { }
+    virtual ~Store();
 
     /**
      * @todo move to `StoreConfig` one we store enough information in
@@ -293,6 +313,25 @@ public:
      */
     std::optional<std::shared_ptr<const ValidPathInfo>> queryPathInfoFromClientCache(const StorePath & path);
 
+    /**
+     * Version of queryPathInfoFromClientCache() for a set of paths.
+     * Paths that are not in the local narinfo cache are omitted from
+     * the result; paths that are known to not exist map to `nullptr`.
+     */
+    std::map<StorePath, std::shared_ptr<const ValidPathInfo>> queryPathInfosFromClientCache(const StorePathSet & paths);
+
+    /**
+     * Query information about a set of paths. Paths that are not
+     * valid map to `nullptr`. Unlike calling queryPathInfo() for each
+     * path, this looks up all paths in the local narinfo cache in a
+     * single transaction, and then queries the missing paths
+     * concurrently, with a bounded number of queries in flight.
+     *
+     * @throws the first error (other than `InvalidPath`) encountered
+     * while querying the store, after all queries have finished.
+     */
+    std::map<StorePath, std::shared_ptr<const ValidPathInfo>> queryPathInfos(const StorePathSet & paths);
+
     /**
      * Query the information about a realisation.
      */
@@ -304,6 +343,12 @@ public:
     void queryRealisation(const DrvOutput &,
         Callback<std::shared_ptr<const Realisation>> callback) noexcept;
 
+    /**
+     * Query the information about a set of realisations. Unknown
+     * realisations map to `nullptr`.
+     */
+    virtual std::map<DrvOutput, std::shared_ptr<const Realisation>> queryRealisations(const std::set<DrvOutput> & ids);
+
 
     /**
      * Check whether the given valid path info is sufficiently attested, by
@@ -333,6 +378,14 @@ protected:
     virtual void queryRealisationUncached(const DrvOutput &,
         Callback<std::shared_ptr<const Realisation>> callback) noexcept = 0;
 
+    /**
+     * Query information about a set of paths without consulting the
+     * caches, for queryPathInfos(). Paths that are not valid map to
+     * `nullptr` or are omitted. The default implementation calls
+     * queryPathInfoUncached() concurrently.
+     */
+    virtual std::map<StorePath, std::shared_ptr<const ValidPathInfo>> queryPathInfosUncached(const StorePathSet & paths);
+
 public:
 
     /**
@@ -703,10 +756,26 @@ public:
         std::atomic<uint64_t> narWriteBytes{0};
         std::atomic<uint64_t> narWriteCompressedBytes{0};
         std::atomic<uint64_t> narWriteCompressionTimeMs{0};
+        std::atomic<uint64_t> narWriteUploadTimeMs{0};
     };
 
     const Stats & getStats();
 
+    /**
+     * Return the latency and error statistics of the queries made to
+     * this store by queryPathInfo().
+     */
+    QueryStats getQueryStats();
+
+    /**
+     * Write the query statistics to the narinfo disk cache, so that
+     * later invocations can use them. To avoid a database write per
+     * call, this does nothing if the statistics were written less
+     * than a minute ago; the remaining changes are written when the
+     * store is destroyed.
+     */
+    void saveQueryStats();
+
     /**
      * Computes the full closure of of a set of store-paths for e.g.
      * derivations that need this information for `exportReferencesGraph`.
@@ -776,6 +845,28 @@ protected:
 
     Stats stats;
 
+    /**
+     * Record the outcome of a query to the underlying store that was
+     * started at `start` in `queryStats`.
+     */
+    void recordQuery(std::chrono::steady_clock::time_point start, bool error);
+
+private:
+
+    /**
+     * Initialise the query statistics from the narinfo disk cache the
+     * first time they are needed.
+     */
+    QueryStats & loadQueryStats(QueryStatsState & state);
+
+    /**
+     * Implementation of saveQueryStats(). If `force` is set, write
+     * any changes regardless of when the last write was.
+     */
+    void writeQueryStats(bool force);
+
+protected:
+
     /**
      * Helper for methods that are not unsupported: this is used for
      * default definitions for virtual methods that are meant to be overriden.
@@ -188,8 +188,7 @@ Goal::Co LocalDerivationGoal::tryLocalBuild()
     additionalSandboxProfile = parsedDrv->getStringAttr("__sandboxProfile").value_or("");
 #endif
 
-    unsigned int curBuilds = worker.getNrLocalBuilds();
-    if (curBuilds >= settings.maxBuildJobs) {
+    if (!worker.canStartLocalBuild()) {
         worker.waitForBuildSlot(shared_from_this());
         outputLocks.unlock();
         co_await Suspend{};
@@ -1205,7 +1204,7 @@ void LocalDerivationGoal::initEnv()
     env["NIX_STORE"] = worker.store.storeDir;
 
     /* The maximum number of cores to utilize for parallel building. */
-    env["NIX_BUILD_CORES"] = fmt("%d", settings.buildCores);
+    env["NIX_BUILD_CORES"] = fmt("%d", worker.getBuildCores());
 
     initTmpDir();
 
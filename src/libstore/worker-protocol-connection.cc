@@ -5,7 +5,9 @@
 
 namespace nix {
 
-const std::set<WorkerProto::Feature> WorkerProto::allFeatures{};
+const WorkerProto::Feature WorkerProto::featureBatchedQueries = "batched-queries";
+
+const std::set<WorkerProto::Feature> WorkerProto::allFeatures{featureBatchedQueries};
 
 WorkerProto::BasicClientConnection::~BasicClientConnection()
 {
@@ -266,6 +268,16 @@ UnkeyedValidPathInfo WorkerProto::BasicClientConnection::queryPathInfo(
     return WorkerProto::Serialise<UnkeyedValidPathInfo>::read(store, *this);
 }
 
+std::vector<ValidPathInfo> WorkerProto::BasicClientConnection::queryPathInfos(
+    const StoreDirConfig & store, bool * daemonException, const StorePathSet & paths)
+{
+    assert(features.count(featureBatchedQueries));
+    to << WorkerProto::Op::QueryPathInfos;
+    WorkerProto::write(store, *this, paths);
+    processStderr(daemonException);
+    return WorkerProto::Serialise<std::vector<ValidPathInfo>>::read(store, *this);
+}
+
 StorePathSet WorkerProto::BasicClientConnection::queryValidPaths(
     const StoreDirConfig & store, bool * daemonException, const StorePathSet & paths, SubstituteFlag maybeSubstitute)
 {
@@ -114,6 +114,12 @@ struct WorkerProto::BasicClientConnection : WorkerProto::BasicConnection
 
     UnkeyedValidPathInfo queryPathInfo(const StoreDirConfig & store, bool * daemonException, const StorePath & path);
 
+    /**
+     * Requires `featureBatchedQueries`. Returns the infos of the paths
+     * in `paths` that are valid.
+     */
+    std::vector<ValidPathInfo> queryPathInfos(const StoreDirConfig & store, bool * daemonException, const StorePathSet & paths);
+
     void putBuildDerivationRequest(
         const StoreDirConfig & store,
         bool * daemonException,
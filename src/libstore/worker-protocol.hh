@@ -136,6 +136,13 @@ struct WorkerProto
 
     using Feature = std::string;
 
+    /**
+     * The daemon supports `Op::QueryPathInfos` and
+     * `Op::QueryRealisations`, which answer a set of queries in a
+     * single round trip.
+     */
+    static const Feature featureBatchedQueries;
+
     static const std::set<Feature> allFeatures;
 };
 
@@ -185,6 +192,8 @@ enum struct WorkerProto::Op : uint64_t
     AddBuildLog = 45,
     BuildPathsWithResults = 46,
     AddPermRoot = 47,
+    QueryPathInfos = 48,
+    QueryRealisations = 49,
 };
 
 struct WorkerProto::ClientHandshakeInfo
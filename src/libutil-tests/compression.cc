@@ -93,4 +93,54 @@ namespace nix {
         ASSERT_STREQ(strSink.s.c_str(), inputString);
     }
 
+    /* ----------------------------------------------------------------------------
+     * seekable compression
+     * --------------------------------------------------------------------------*/
+
+    TEST(makeSeekableCompressionSink, unsupportedMethod) {
+        StringSink strSink;
+        ASSERT_THROW(makeSeekableCompressionSink("xz", strSink, 1024), UnknownCompressionMethod);
+    }
+
+    TEST(makeSeekableCompressionSink, readRanges) {
+        std::string input;
+        for (int i = 0; i < 10000; ++i)
+            input += fmt("line %d\n", i);
+
+        StringSink strSink;
+        auto sink = makeSeekableCompressionSink("zstd", strSink, 1000);
+        (*sink)(input);
+        sink->finish();
+        auto & compressed = strSink.s;
+
+        /* Regular decompressors see a normal zstd stream. */
+        ASSERT_EQ(decompress("zstd", compressed), input);
+
+        auto tableSize = SeekTable::tableSize(compressed.substr(compressed.size() - SeekTable::footerSize));
+        ASSERT_TRUE(tableSize);
+        auto table = SeekTable::parse(compressed.substr(compressed.size() - *tableSize));
+        ASSERT_EQ(table.frames.size(), (input.size() + 999) / 1000);
+
+        for (auto [offset, length] : std::vector<std::pair<size_t, size_t>>{
+                {0, 10}, {995, 10}, {1000, 1000}, {12345, 23456}, {input.size() - 1, 1}})
+        {
+            auto [first, last] = table.findFrames(offset, length);
+            auto & firstFrame = table.frames[first];
+            auto & lastFrame = table.frames[last - 1];
+            auto frames = compressed.substr(
+                firstFrame.compressedOffset,
+                lastFrame.compressedOffset + lastFrame.compressedSize - firstFrame.compressedOffset);
+            ASSERT_EQ(
+                decompress("zstd", frames).substr(offset - firstFrame.uncompressedOffset, length),
+                input.substr(offset, length));
+        }
+
+        ASSERT_THROW(table.findFrames(input.size(), 1), CompressionError);
+    }
+
+    TEST(makeSeekableCompressionSink, notSeekable) {
+        auto compressed = compress("zstd", "foo bar");
+        ASSERT_FALSE(SeekTable::tableSize(compressed.substr(compressed.size() - SeekTable::footerSize)));
+    }
+
 }
@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <random>
+
+#include "archive.hh"
+#include "file-system.hh"
+#include "hash.hh"
+
+namespace nix {
+
+static std::string makeData(size_t size)
+{
+    std::mt19937 rng(42);
+    std::string data(size, 0);
+    for (auto & c : data)
+        c = (char) rng();
+    return data;
+}
+
+/**
+ * Hash the NAR serialisation of a single file. Argument: file size.
+ */
+static void BM_HashNarString(benchmark::State & state)
+{
+    auto data = makeData(state.range(0));
+
+    for (auto _ : state) {
+        HashSink sink(HashAlgorithm::SHA256);
+        dumpString(data, sink);
+        benchmark::DoNotOptimize(sink.finish());
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK(BM_HashNarString)
+    ->ArgName("size")
+    ->Arg(4 << 10)
+    ->Arg(1 << 20)
+    ->Arg(64 << 20);
+
+/**
+ * Hash the NAR serialisation of a directory on disk, as
+ * `nix-store --verify --check-contents` does. Arguments: number of
+ * files and their size.
+ */
+static void BM_HashNarTree(benchmark::State & state)
+{
+    auto nrFiles = (size_t) state.range(0);
+    auto data = makeData(state.range(1));
+
+    auto tmpDir = createTempDir();
+    AutoDelete delTmpDir(tmpDir);
+    auto root = tmpDir + "/root";
+    createDirs(root);
+    for (size_t n = 0; n < nrFiles; ++n)
+        writeFile(fmt("%s/%d", root, n), data);
+
+    for (auto _ : state) {
+        HashSink sink(HashAlgorithm::SHA256);
+        dumpPath(root, sink);
+        benchmark::DoNotOptimize(sink.finish());
+    }
+
+    state.SetBytesProcessed(state.iterations() * nrFiles * data.size());
+}
+
+BENCHMARK(BM_HashNarTree)
+    ->ArgNames({"files", "size"})
+    ->Args({1000, 4 << 10})
+    ->Args({16, 1 << 20});
+
+static Hash makeHash()
+{
+    return hashString(HashAlgorithm::SHA256, "benchmark");
+}
+
+static void BM_HashToNix32(benchmark::State & state)
+{
+    auto hash = makeHash();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(hash.to_string(HashFormat::Nix32, true));
+}
+
+BENCHMARK(BM_HashToNix32);
+
+/**
+ * Parse a SHA-256 hash with `Hash::parseAny()`. Argument: the format
+ * of the input (0 = nix32, 1 = base16, 2 = SRI).
+ */
+static void BM_HashParseAny(benchmark::State & state)
+{
+    auto format = std::array{HashFormat::Nix32, HashFormat::Base16, HashFormat::SRI}[state.range(0)];
+    auto s = makeHash().to_string(format, true);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Hash::parseAny(s, std::nullopt));
+}
+
+BENCHMARK(BM_HashParseAny)
+    ->ArgName("format")
+    ->DenseRange(0, 2);
+
+}
+
+BENCHMARK_MAIN();
@@ -38,9 +38,48 @@ INSTANTIATE_TEST_CASE_P(
     ::testing::Values(
         RewriteParams{ "foooo", "baroo", {{"foo", "bar"}, {"bar", "baz"}}},
         RewriteParams{ "foooo", "bazoo", {{"fou", "bar"}, {"foo", "baz"}}},
-        RewriteParams{ "foooo", "foooo", {}}
+        RewriteParams{ "foooo", "foooo", {}},
+        RewriteParams{ "abcabc", "xyzxyz", {{"abc", "xyz"}}},
+        RewriteParams{ "abcdef", "ABCDEF", {{"abc", "ABC"}, {"def", "DEF"}}},
+        RewriteParams{ "aaaa", "bbbb", {{"aa", "bb"}}},
+        RewriteParams{ "abcd", "xycd", {{"ab", "xy"}, {"bc", "zz"}}},
+        RewriteParams{ "abcd", "XYZd", {{"ab", "xy"}, {"abc", "XYZ"}}},
+        RewriteParams{ "a-b-c", "x-b-z", {{"a", "x"}, {"c", "z"}}},
+        RewriteParams{ "ab", "ba", {{"a", "b"}, {"b", "a"}}}
     )
 );
 
+TEST_P(RewriteTest, ChunkingDoesNotMatter) {
+    RewriteParams param = GetParam();
+    for (size_t chunkSize = 1; chunkSize <= param.originalString.size(); ++chunkSize) {
+        StringSink rewritten;
+        auto rewriter = RewritingSink(param.rewrites, rewritten);
+        for (size_t i = 0; i < param.originalString.size(); i += chunkSize)
+            rewriter(std::string_view(param.originalString).substr(i, chunkSize));
+        rewriter.flush();
+        ASSERT_EQ(rewritten.s, param.finalString) << "chunk size " << chunkSize;
+        ASSERT_EQ(rewriter.pos, param.finalString.size());
+    }
+}
+
+TEST(RewritingSink, manyPatterns) {
+    StringMap rewrites;
+    std::string original, expected;
+    for (int i = 0; i < 1000; ++i) {
+        auto from = fmt("%032d", i);
+        auto to = fmt("%032d", i + 1000000);
+        rewrites.emplace(from, to);
+        original += "|" + from;
+        expected += "|" + to;
+    }
+
+    StringSink rewritten;
+    RewritingSink rewriter(rewrites, rewritten);
+    for (size_t i = 0; i < original.size(); i += 1000)
+        rewriter(std::string_view(original).substr(i, 1000));
+    rewriter.flush();
+    ASSERT_EQ(rewritten.s, expected);
+}
+
 }
 
@@ -0,0 +1,68 @@
+#include "serialise.hh"
+
+#include <gtest/gtest.h>
+
+namespace nix {
+
+    /* ----------------------------------------------------------------------------
+     * sinkToSourceThreaded
+     * --------------------------------------------------------------------------*/
+
+    TEST(sinkToSourceThreaded, transfersAllData) {
+        std::string expected;
+        for (size_t i = 0; i < 100000; ++i)
+            expected += std::to_string(i);
+
+        /* Use a small buffer so that the producer has to wait for the
+           consumer. */
+        auto source = sinkToSourceThreaded([&](Sink & sink) {
+            for (size_t i = 0; i < expected.size(); i += 1000)
+                sink(std::string_view(expected).substr(i, 1000));
+        }, []() { throw EndOfFile("done"); }, 4096);
+
+        ASSERT_EQ(source->drain(), expected);
+    }
+
+    TEST(sinkToSourceThreaded, callsEof) {
+        auto source = sinkToSourceThreaded([&](Sink & sink) {
+            sink("foo");
+        }, []() { throw Error("no more data"); });
+
+        char buf[3];
+        source->operator()(buf, sizeof(buf));
+        ASSERT_EQ(std::string_view(buf, sizeof(buf)), "foo");
+        ASSERT_THROW(source->operator()(buf, 1), Error);
+    }
+
+    TEST(sinkToSourceThreaded, propagatesExceptions) {
+        auto source = sinkToSourceThreaded([&](Sink & sink) {
+            sink("foo");
+            throw UsageError("broken");
+        });
+
+        char buf[3];
+        source->operator()(buf, sizeof(buf));
+        ASSERT_THROW(source->operator()(buf, 1), UsageError);
+    }
+
+    TEST(sinkToSourceThreaded, stopsProducerWhenDestroyed) {
+        bool stopped = false;
+
+        {
+            auto source = sinkToSourceThreaded([&](Sink & sink) {
+                try {
+                    while (true) sink(std::string(1024, 'x'));
+                } catch (EndOfFile &) {
+                    stopped = true;
+                    throw;
+                }
+            }, []() { throw EndOfFile("done"); }, 4096);
+
+            char buf[16];
+            source->operator()(buf, sizeof(buf));
+        }
+
+        ASSERT_TRUE(stopped);
+    }
+
+}
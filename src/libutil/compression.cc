@@ -3,6 +3,7 @@
 #include "tarfile.hh"
 #include "finally.hh"
 #include "logging.hh"
+#include "util.hh"
 
 #include <archive.h>
 #include <archive_entry.h>
@@ -298,6 +299,134 @@ ref<CompressionSink> makeCompressionSink(const std::string & method, Sink & next
         throw UnknownCompressionMethod("unknown compression method '%s'", method);
 }
 
+/* See https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md. */
+static const uint32_t zstdSkippableFrameMagic = 0x184D2A5E;
+static const uint32_t zstdSeekableMagic = 0x8F92EAB1;
+
+static void writeLittleEndian32(std::string & s, uint32_t n)
+{
+    for (int i = 0; i < 4; ++i)
+        s.push_back((char) (n >> (i * 8)));
+}
+
+struct SeekableZstdCompressionSink : CompressionSink
+{
+    Sink & nextSink;
+    size_t frameSize;
+    int level;
+    std::string frame;
+    std::string seekTable;
+    uint32_t nrFrames = 0;
+
+    SeekableZstdCompressionSink(Sink & nextSink, size_t frameSize, int level)
+        : nextSink(nextSink)
+        , frameSize(frameSize)
+        , level(level)
+    {
+        assert(frameSize > 0 && frameSize <= std::numeric_limits<uint32_t>::max());
+    }
+
+    void writeUnbuffered(std::string_view data) override
+    {
+        while (!data.empty()) {
+            auto n = std::min(frameSize - frame.size(), data.size());
+            frame.append(data.substr(0, n));
+            data.remove_prefix(n);
+            if (frame.size() == frameSize)
+                writeFrame();
+        }
+    }
+
+    void writeFrame()
+    {
+        auto compressed = compress("zstd", frame, false, level);
+        if (compressed.size() > std::numeric_limits<uint32_t>::max())
+            throw CompressionError("compressed frame is too large");
+        nextSink(compressed);
+        writeLittleEndian32(seekTable, compressed.size());
+        writeLittleEndian32(seekTable, frame.size());
+        nrFrames++;
+        frame.clear();
+    }
+
+    void finish() override
+    {
+        flush();
+        /* Always write at least one frame, so that the output is a
+           valid zstd stream. */
+        if (!frame.empty() || !nrFrames)
+            writeFrame();
+
+        std::string table;
+        writeLittleEndian32(table, zstdSkippableFrameMagic);
+        writeLittleEndian32(table, seekTable.size() + SeekTable::footerSize);
+        table += seekTable;
+        writeLittleEndian32(table, nrFrames);
+        table.push_back(0); // descriptor: no checksums
+        writeLittleEndian32(table, zstdSeekableMagic);
+        nextSink(table);
+    }
+};
+
+ref<CompressionSink> makeSeekableCompressionSink(
+    const std::string & method, Sink & nextSink, size_t frameSize, int level)
+{
+    if (method != "zstd")
+        throw UnknownCompressionMethod("compression method '%s' does not support seekable compression", method);
+    return make_ref<SeekableZstdCompressionSink>(nextSink, frameSize, level);
+}
+
+std::optional<size_t> SeekTable::tableSize(std::string_view footer)
+{
+    if (footer.size() != footerSize) return std::nullopt;
+    auto p = (unsigned char *) footer.data();
+    if (readLittleEndian<uint32_t>(p + 5) != zstdSeekableMagic) return std::nullopt;
+    /* Checksums would make the entries bigger. We never write them. */
+    if (p[4] & 0x80) return std::nullopt;
+    return 8 + (size_t) readLittleEndian<uint32_t>(p) * 8 + footerSize;
+}
+
+SeekTable SeekTable::parse(std::string_view table)
+{
+    if (table.size() < 8 + footerSize)
+        throw CompressionError("seek table is too short");
+    auto p = (unsigned char *) table.data();
+    auto nrFrames = readLittleEndian<uint32_t>(p + table.size() - footerSize);
+    if (readLittleEndian<uint32_t>(p) != zstdSkippableFrameMagic
+        || readLittleEndian<uint32_t>(p + 4) != table.size() - 8
+        || table.size() != 8 + (size_t) nrFrames * 8 + footerSize)
+        throw CompressionError("seek table is malformed");
+
+    SeekTable res;
+    uint64_t compressedOffset = 0, uncompressedOffset = 0;
+    for (uint32_t i = 0; i < nrFrames; ++i) {
+        Frame frame{
+            .compressedOffset = compressedOffset,
+            .uncompressedOffset = uncompressedOffset,
+            .compressedSize = readLittleEndian<uint32_t>(p + 8 + i * 8),
+            .uncompressedSize = readLittleEndian<uint32_t>(p + 8 + i * 8 + 4),
+        };
+        compressedOffset += frame.compressedSize;
+        uncompressedOffset += frame.uncompressedSize;
+        res.frames.push_back(frame);
+    }
+    return res;
+}
+
+std::pair<size_t, size_t> SeekTable::findFrames(uint64_t offset, uint64_t length) const
+{
+    auto containing = [&](uint64_t pos) {
+        return std::upper_bound(frames.begin(), frames.end(), pos,
+            [](uint64_t pos, const Frame & frame) { return pos < frame.uncompressedOffset; }) - frames.begin() - 1;
+    };
+    if (length == 0 || frames.empty()) return {0, 0};
+    auto first = containing(offset);
+    auto last = containing(offset + length - 1) + 1;
+    if (first < 0 || offset + length > frames.back().uncompressedOffset + frames.back().uncompressedSize)
+        throw CompressionError("range [%d, %d) is outside of the compressed data", offset, offset + length);
+    return {first, last};
+}
+
 std::string compress(const std::string & method, std::string_view in, const bool parallel, int level)
 {
     StringSink ssink;
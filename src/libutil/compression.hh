@@ -25,6 +25,60 @@ std::string compress(const std::string & method, std::string_view in, const bool
 ref<CompressionSink>
 makeCompressionSink(const std::string & method, Sink & nextSink, const bool parallel = false, int level = -1);
 
+/**
+ * Return a sink that compresses its input as a sequence of
+ * independently compressed frames of (at most) `frameSize`
+ * uncompressed bytes, followed by a seek table that maps uncompressed
+ * offsets to frames. This allows a range of the uncompressed data to
+ * be read by decompressing only the frames that contain it. Only
+ * `zstd` is supported; the output follows the zstd seekable format,
+ * so regular zstd decompressors can read it in its entirety.
+ */
+ref<CompressionSink> makeSeekableCompressionSink(
+    const std::string & method, Sink & nextSink, size_t frameSize, int level = -1);
+
+/**
+ * The seek table of data written by `makeSeekableCompressionSink()`.
+ */
+struct SeekTable
+{
+    struct Frame
+    {
+        uint64_t compressedOffset;
+        uint64_t uncompressedOffset;
+        uint32_t compressedSize;
+        uint32_t uncompressedSize;
+    };
+
+    std::vector<Frame> frames;
+
+    /**
+     * The number of bytes at the end of the compressed data that
+     * `tableSize()` needs.
+     */
+    static constexpr size_t footerSize = 9;
+
+    /**
+     * Given the last `footerSize` bytes of the compressed data,
+     * return the size of the seek table at the end of it, or
+     * `std::nullopt` if the data is not seekable.
+     */
+    static std::optional<size_t> tableSize(std::string_view footer);
+
+    /**
+     * Parse the last `tableSize(footer)` bytes of the compressed data.
+     *
+     * @throws CompressionError if the table is malformed.
+     */
+    static SeekTable parse(std::string_view table);
+
+    /**
+     * Return the range of frames [first, last) that contain the
+     * uncompressed bytes [offset, offset + length).
+     */
+    std::pair<size_t, size_t> findFrames(uint64_t offset, uint64_t length) const;
+};
+
 MakeError(UnknownCompressionMethod, Error);
 
 MakeError(CompressionError, Error);
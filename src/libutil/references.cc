@@ -4,65 +4,209 @@
 
 #include <map>
 #include <cstdlib>
-#include <mutex>
+#include <cstring>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 
 namespace nix {
 
 
-static size_t refLength = 32; /* characters */
+static constexpr size_t refLength = RefScanSink::refLength;
 
 
-static void search(
-    std::string_view s,
-    StringSet & hashes,
-    StringSet & seen)
+/* Not a global, since `nix32Chars` may not have been initialised
+   yet. */
+static const std::array<bool, 256> & nix32Table()
 {
-    static std::once_flag initialised;
-    static bool isBase32[256];
-    std::call_once(initialised, [](){
-        for (unsigned int i = 0; i < 256; ++i) isBase32[i] = false;
-        for (unsigned int i = 0; i < nix32Chars.size(); ++i)
-            isBase32[(unsigned char) nix32Chars[i]] = true;
-    });
+    static const auto res = []() {
+        std::array<bool, 256> res{};
+        for (auto c : nix32Chars)
+            res[(unsigned char) c] = true;
+        return res;
+    }();
+    return res;
+}
 
-    for (size_t i = 0; i + refLength <= s.size(); ) {
-        int j;
-        bool match = true;
-        for (j = refLength - 1; j >= 0; --j)
-            if (!isBase32[(unsigned char) s[i + j]]) {
-                i += j + 1;
-                match = false;
-                break;
+
+/**
+ * Return a mask in which bit `i` is set iff `p[i]` is a nix32
+ * character, for the 64 bytes at `p`.
+ */
+static inline uint64_t nix32Mask(const char * p)
+{
+#if defined(__SSE2__)
+    /* nix32Chars is [0-9a-z] without 'e', 'o', 't' and 'u'. Bytes
+       >= 0x80 compare as negative and thus fall outside both ranges. */
+    auto inRange = [](__m128i c, char lo, char hi) {
+        return _mm_and_si128(
+            _mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)),
+            _mm_cmplt_epi8(c, _mm_set1_epi8(hi + 1)));
+    };
+    auto is = [](__m128i c, char x) {
+        return _mm_cmpeq_epi8(c, _mm_set1_epi8(x));
+    };
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        auto c = _mm_loadu_si128((const __m128i *) (p + i * 16));
+        auto ok = _mm_or_si128(inRange(c, '0', '9'), inRange(c, 'a', 'z'));
+        auto excluded = _mm_or_si128(
+            _mm_or_si128(is(c, 'e'), is(c, 'o')),
+            _mm_or_si128(is(c, 't'), is(c, 'u')));
+        ok = _mm_andnot_si128(excluded, ok);
+        mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(ok) << (i * 16);
+    }
+    return mask;
+#else
+    auto & isNix32 = nix32Table();
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; ++i)
+        mask |= (uint64_t) isNix32[(unsigned char) p[i]] << i;
+    return mask;
+#endif
+}
+
+
+/**
+ * Given the nix32 masks of two consecutive 64-byte blocks, return a
+ * mask in which bit `i` is set iff a run of at least `refLength`
+ * nix32 characters starts at byte `i` of the first block.
+ */
+static inline uint64_t runStarts(uint64_t lo, uint64_t hi)
+{
+    for (size_t shift = 1; shift < refLength; shift *= 2) {
+        lo &= (lo >> shift) | (hi << (64 - shift));
+        hi &= hi >> shift;
+    }
+    return lo;
+}
+
+
+RefScanSink::RefScanSink(StringSet && hashes)
+{
+    auto tableSize = std::bit_ceil(std::max<size_t>(16, hashes.size() * 2));
+    tableShift = 64 - std::countr_zero(tableSize);
+    table.resize(tableSize, 0);
+
+    for (auto & hash : hashes) {
+        /* Only hash parts can be found. */
+        if (hash.size() != refLength) continue;
+        uint64_t key;
+        memcpy(&key, hash.data(), sizeof(key));
+        auto j = (key * 0x9e3779b97f4a7c15ULL) >> tableShift;
+        while (table[j]) j = (j + 1) & (tableSize - 1);
+        this->hashes.push_back(hash);
+        table[j] = this->hashes.size();
+    }
+
+    found.resize(this->hashes.size(), false);
+}
+
+
+void RefScanSink::check(const char * candidate)
+{
+    uint64_t key;
+    memcpy(&key, candidate, sizeof(key));
+    for (auto j = (key * 0x9e3779b97f4a7c15ULL) >> tableShift; table[j]; j = (j + 1) & (table.size() - 1)) {
+        auto k = table[j] - 1;
+        if (memcmp(hashes[k].data(), candidate, refLength) == 0) {
+            if (!found[k]) {
+                debug("found reference to '%1%'", hashes[k]);
+                found[k] = true;
+                nrFound++;
+                seen.insert(hashes[k]);
             }
-        if (!match) continue;
-        std::string ref(s.substr(i, refLength));
-        if (hashes.erase(ref)) {
-            debug("found reference to '%1%' at offset '%2%'", ref, i);
-            seen.insert(ref);
+            return;
+        }
+    }
+}
+
+
+void RefScanSink::search(std::string_view s)
+{
+    auto & isNix32 = nix32Table();
+
+    /* Look for a window of `refLength` nix32 characters, checking
+       the last byte of the window first. In binary data it usually
+       isn't one, so we can skip ahead by a whole window. Bytes known
+       to be nix32 characters are not examined again.
+
+       Once a window is found, the data is likely text with many
+       candidates, so switch to processing it in blocks of 64 bytes.
+       For each block we compute which bytes are nix32 characters,
+       and from that (and the next block) where runs of `refLength`
+       of them start. Only those positions are looked up. The last,
+       partial block is padded with zeroes, which are not nix32
+       characters. We go back to skipping after a block without any
+       runs. */
+    auto blockMask = [&](size_t offset) -> uint64_t {
+        if (offset >= s.size()) return 0;
+        if (offset + 64 <= s.size()) return nix32Mask(s.data() + offset);
+        char buf[64] = {};
+        memcpy(buf, s.data() + offset, s.size() - offset);
+        return nix32Mask(buf);
+    };
+
+    /* `s[i, i + good)` are known to be nix32 characters. */
+    size_t good = 0;
+    for (size_t i = 0; i + refLength <= s.size(); ) {
+        size_t j = refLength;
+        while (j > good && isNix32[(unsigned char) s[i + j - 1]]) --j;
+        if (j > good) {
+            i += j;
+            good = refLength - j;
+            continue;
+        }
+
+        auto cur = blockMask(i);
+        while (true) {
+            auto next = blockMask(i + 64);
+            auto starts = runStarts(cur, next);
+            if (!starts) break;
+            for (; starts; starts &= starts - 1)
+                check(s.data() + i + std::countr_zero(starts));
+            if (nrFound == hashes.size()) return;
+            i += 64;
+            cur = next;
         }
-        ++i;
+        i += 64;
+        good = 0;
     }
 }
 
 
 void RefScanSink::operator () (std::string_view data)
 {
+    if (nrFound == hashes.size()) return;
+
     /* It's possible that a reference spans the previous and current
        fragment, so search in the concatenation of the tail of the
        previous fragment and the start of the current fragment. */
-    auto s = tail;
-    auto tailLen = std::min(data.size(), refLength);
-    s.append(data.data(), tailLen);
-    search(s, hashes, seen);
+    if (tailLen) {
+        std::array<char, 2 * (refLength - 1)> buf;
+        auto n = std::min(data.size(), refLength - 1);
+        memcpy(buf.data(), tail.data(), tailLen);
+        memcpy(buf.data() + tailLen, data.data(), n);
+        search({buf.data(), tailLen + n});
+    }
 
-    search(data, hashes, seen);
+    search(data);
 
-    auto rest = refLength - tailLen;
-    if (rest < tail.size())
-        tail = tail.substr(tail.size() - rest);
-    tail.append(data.data() + data.size() - tailLen, tailLen);
+    if (data.size() >= tail.size()) {
+        memcpy(tail.data(), data.data() + data.size() - tail.size(), tail.size());
+        tailLen = tail.size();
+    } else {
+        auto keep = std::min(tailLen, tail.size() - data.size());
+        memmove(tail.data(), tail.data() + tailLen - keep, keep);
+        memcpy(tail.data() + keep, data.data(), data.size());
+        tailLen = keep + data.size();
+    }
 }
 
 
@@ -71,42 +215,129 @@ RewritingSink::RewritingSink(const std::string & from, const std::string & to, S
 {
 }
 
+static inline uint64_t patternKey(const char * p, size_t length)
+{
+    uint64_t key = 0;
+    memcpy(&key, p, std::min(length, sizeof(key)));
+    return key * 0x9e3779b97f4a7c15ULL;
+}
+
 RewritingSink::RewritingSink(const StringMap & rewrites, Sink & nextSink)
-    : rewrites(rewrites), nextSink(nextSink)
+    : rewrites(rewrites), nextSink(nextSink), firstBytes(1 << 16, false)
 {
-    std::string::size_type maxRewriteSize = 0;
-    for (auto & [from, to] : rewrites) {
+    std::map<size_t, std::vector<const StringMap::value_type *>, std::greater<size_t>> byLength;
+
+    for (auto & rewrite : this->rewrites) {
+        auto & [from, to] = rewrite;
         assert(from.size() == to.size());
+        if (from.empty() || from == to) continue;
         maxRewriteSize = std::max(maxRewriteSize, from.size());
+        byLength[from.size()].push_back(&rewrite);
+
+        auto b0 = (unsigned char) from[0];
+        if (from.size() == 1)
+            for (unsigned int b1 = 0; b1 < 256; ++b1)
+                firstBytes[b0 << 8 | b1] = true;
+        else
+            firstBytes[b0 << 8 | (unsigned char) from[1]] = true;
+    }
+
+    for (auto & [length, patterns] : byLength) {
+        auto tableSize = std::bit_ceil(std::max<size_t>(16, patterns.size() * 2));
+        PatternTable t{
+            .length = length,
+            .shift = (unsigned int) (64 - std::countr_zero(tableSize)),
+            .table = std::vector<const StringMap::value_type *>(tableSize, nullptr),
+        };
+        for (auto pattern : patterns) {
+            auto j = patternKey(pattern->first.data(), length) >> t.shift;
+            while (t.table[j]) j = (j + 1) & (tableSize - 1);
+            t.table[j] = pattern;
+        }
+        patternTables.push_back(std::move(t));
     }
-    this->maxRewriteSize = maxRewriteSize;
 }
 
-void RewritingSink::operator () (std::string_view data)
+const StringMap::value_type * RewritingSink::match(std::string_view s, size_t i)
+{
+    for (auto & t : patternTables) {
+        if (i + t.length > s.size()) continue;
+        auto p = s.data() + i;
+        auto key = patternKey(p, t.length);
+        for (auto j = key >> t.shift; t.table[j]; j = (j + 1) & (t.table.size() - 1))
+            if (memcmp(t.table[j]->first.data(), p, t.length) == 0)
+                return t.table[j];
+    }
+    return nullptr;
+}
+
+size_t RewritingSink::rewrite(std::string_view s, size_t limit, bool final)
 {
-    std::string s(prev);
-    s.append(data);
+    auto end = final
+        ? s.size()
+        : s.size() >= maxRewriteSize ? s.size() - maxRewriteSize + 1 : 0;
+    end = std::min(end, limit);
 
-    s = rewriteStrings(s, rewrites);
+    size_t done = 0, i = 0;
 
-    prev = s.size() < maxRewriteSize
-        ? s
-        : maxRewriteSize == 0
-            ? ""
-            : std::string(s, s.size() - maxRewriteSize + 1, maxRewriteSize - 1);
+    auto emit = [&](std::string_view data) {
+        if (data.empty()) return;
+        pos += data.size();
+        nextSink(data);
+    };
 
-    auto consumed = s.size() - prev.size();
+    while (i < end) {
+        if (i + 1 < s.size() && !firstBytes[(unsigned char) s[i] << 8 | (unsigned char) s[i + 1]]) {
+            ++i;
+            continue;
+        }
+        if (auto m = match(s, i)) {
+            emit(s.substr(done, i - done));
+            emit(m->second);
+            i += m->first.size();
+            done = i;
+        } else
+            ++i;
+    }
 
-    pos += consumed;
+    if (final) i = s.size();
+    emit(s.substr(done, i - done));
+    return i;
+}
+
+void RewritingSink::operator () (std::string_view data)
+{
+    if (patternTables.empty()) {
+        pos += data.size();
+        if (!data.empty()) nextSink(data);
+        return;
+    }
+
+    /* A match may span the previous and the current fragment. Handle
+       the positions in the unprocessed tail of the previous fragment
+       first, using just enough of the current fragment, so that the
+       current fragment itself doesn't need to be copied. */
+    if (!prev.empty()) {
+        auto prevLen = prev.size();
+        prev.append(data.substr(0, maxRewriteSize - 1));
+        if (data.size() < maxRewriteSize - 1) {
+            prev.erase(0, rewrite(prev, prev.size(), false));
+            return;
+        }
+        auto consumed = rewrite(prev, prevLen, false);
+        assert(consumed >= prevLen);
+        data.remove_prefix(consumed - prevLen);
+        prev.clear();
+    }
 
-    if (consumed) nextSink(s.substr(0, consumed));
+    auto consumed = rewrite(data, data.size(), false);
+    prev.assign(data.substr(consumed));
 }
 
 void RewritingSink::flush()
 {
     if (prev.empty()) return;
-    pos += prev.size();
-    nextSink(prev);
+    rewrite(prev, prev.size(), true);
     prev.clear();
 }
 
@@ -5,17 +5,48 @@
 
 namespace nix {
 
+/**
+ * A sink that looks for occurrences of a set of store path hash
+ * parts (32 nix32 characters) in the data written to it.
+ */
 class RefScanSink : public Sink
 {
-    StringSet hashes;
+public:
+
+    static constexpr size_t refLength = 32;
+
+private:
+
+    /**
+     * The hash parts to look for, and whether they have been found.
+     */
+    std::vector<std::string> hashes;
+    std::vector<bool> found;
+    size_t nrFound = 0;
+
+    /**
+     * Open-addressing hash table of indices into `hashes` plus one,
+     * keyed on the first 8 bytes of the hash part. 0 means empty.
+     */
+    std::vector<uint32_t> table;
+    unsigned int tableShift;
+
     StringSet seen;
 
-    std::string tail;
+    /**
+     * The last `refLength - 1` bytes seen, to find references that
+     * span two fragments.
+     */
+    std::array<char, refLength - 1> tail;
+    size_t tailLen = 0;
+
+    void search(std::string_view s);
+
+    void check(const char * candidate);
 
 public:
 
-    RefScanSink(StringSet && hashes) : hashes(hashes)
-    { }
+    RefScanSink(StringSet && hashes);
 
     StringSet & getResult()
     { return seen; }
@@ -23,10 +54,17 @@ public:
     void operator () (std::string_view data) override;
 };
 
+/**
+ * A sink that replaces every occurrence of the keys of `rewrites` by
+ * the corresponding value, which must have the same length, in a
+ * single pass over the data. Where patterns overlap, the leftmost
+ * and then longest one is replaced. Replacements are not rewritten
+ * again.
+ */
 struct RewritingSink : Sink
 {
     const StringMap rewrites;
-    std::string::size_type maxRewriteSize;
+    std::string::size_type maxRewriteSize = 0;
     std::string prev;
     Sink & nextSink;
     uint64_t pos = 0;
@@ -39,6 +77,41 @@ struct RewritingSink : Sink
     void operator () (std::string_view data) override;
 
     void flush();
+
+private:
+
+    /**
+     * The patterns of one length, in an open-addressing hash table
+     * of pointers into `rewrites`, keyed on their first (up to) 8
+     * bytes.
+     */
+    struct PatternTable
+    {
+        size_t length;
+        unsigned int shift;
+        std::vector<const StringMap::value_type *> table;
+    };
+
+    /**
+     * One table per pattern length, longest first.
+     */
+    std::vector<PatternTable> patternTables;
+
+    /**
+     * Whether any pattern starts with a given pair of bytes, to
+     * quickly skip positions that can't match.
+     */
+    std::vector<bool> firstBytes;
+
+    const StringMap::value_type * match(std::string_view s, size_t i);
+
+    /**
+     * Rewrite and pass on `s`, considering matches that start before
+     * `limit`. Unless `final` is set, positions where the longest
+     * pattern doesn't fit are left alone. Returns the number of
+     * bytes passed on.
+     */
+    size_t rewrite(std::string_view s, size_t limit, bool final);
 };
 
 struct HashModuloSink : AbstractHashSink
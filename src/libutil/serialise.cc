@@ -1,10 +1,13 @@
 #include "serialise.hh"
 #include "signals.hh"
 #include "util.hh"
+#include "sync.hh"
 
 #include <cstring>
 #include <cerrno>
+#include <deque>
 #include <memory>
+#include <thread>
 
 #include <boost/coroutine2/coroutine.hpp>
 
@@ -307,6 +310,108 @@ std::unique_ptr<Source> sinkToSource(
 }
 
 
+std::unique_ptr<Source> sinkToSourceThreaded(
+    std::function<void(Sink &)> fun,
+    std::function<void()> eof,
+    size_t bufferSize)
+{
+    struct ThreadedSinkToSource : Source
+    {
+        /* Chunks smaller than this are appended to the previous chunk
+           to reduce the per-chunk overhead. */
+        const size_t minChunkSize = 64 * 1024;
+
+        struct State
+        {
+            std::deque<std::string> chunks;
+            size_t buffered = 0;
+            bool finished = false;
+            bool cancelled = false;
+            std::exception_ptr exc;
+        };
+
+        std::function<void()> eof;
+        size_t bufferSize;
+
+        Sync<State> state_;
+        std::condition_variable wakeup;
+        std::thread thread;
+
+        std::string cur;
+        size_t pos = 0;
+
+        ThreadedSinkToSource(std::function<void(Sink &)> fun, std::function<void()> eof, size_t bufferSize)
+            : eof(eof), bufferSize(bufferSize)
+        {
+            thread = std::thread([this, fun]() {
+                ReceiveInterrupts receiveInterrupts;
+
+                std::exception_ptr exc;
+
+                try {
+                    LambdaSink sink([&](std::string_view data) {
+                        if (data.empty()) return;
+                        auto state(state_.lock());
+                        while (state->buffered >= this->bufferSize && !state->cancelled)
+                            state.wait(wakeup);
+                        if (state->cancelled)
+                            throw EndOfFile("reader has gone away");
+                        if (!state->chunks.empty() && state->chunks.back().size() < minChunkSize)
+                            state->chunks.back().append(data);
+                        else
+                            state->chunks.emplace_back(data);
+                        state->buffered += data.size();
+                        wakeup.notify_all();
+                    });
+                    fun(sink);
+                } catch (...) {
+                    exc = std::current_exception();
+                }
+
+                auto state(state_.lock());
+                state->finished = true;
+                state->exc = exc;
+                wakeup.notify_all();
+            });
+        }
+
+        ~ThreadedSinkToSource()
+        {
+            state_.lock()->cancelled = true;
+            wakeup.notify_all();
+            thread.join();
+        }
+
+        size_t read(char * data, size_t len) override
+        {
+            if (pos == cur.size()) {
+                auto state(state_.lock());
+                while (state->chunks.empty() && !state->finished)
+                    state.wait(wakeup);
+                if (state->chunks.empty()) {
+                    if (state->exc) std::rethrow_exception(state->exc);
+                    eof();
+                    unreachable();
+                }
+                cur = std::move(state->chunks.front());
+                state->chunks.pop_front();
+                state->buffered -= cur.size();
+                pos = 0;
+                wakeup.notify_all();
+            }
+
+            auto n = std::min(cur.size() - pos, len);
+            memcpy(data, cur.data() + pos, n);
+            pos += n;
+
+            return n;
+        }
+    };
+
+    return std::make_unique<ThreadedSinkToSource>(fun, eof, bufferSize);
+}
+
+
 void writePadding(size_t len, Sink & sink)
 {
     if (len % 8) {
@@ -378,6 +378,24 @@ std::unique_ptr<Source> sinkToSource(
     });
 
 
+/**
+ * Like sinkToSource(), but run `fun` in a separate thread, so that
+ * producing and consuming the data happen concurrently. At most
+ * about `bufferSize` bytes are buffered between the two threads;
+ * `fun` blocks while the buffer is full.
+ *
+ * If the source is destroyed before `fun` has returned, writes to its
+ * sink throw `EndOfFile`, and the destructor waits for `fun` to
+ * return. Exceptions thrown by `fun` are rethrown to the reader.
+ */
+std::unique_ptr<Source> sinkToSourceThreaded(
+    std::function<void(Sink &)> fun,
+    std::function<void()> eof = []() {
+        throw EndOfFile("producer thread has finished");
+    },
+    size_t bufferSize = 8 * 1024 * 1024);
+
+
 void writePadding(size_t len, Sink & sink);
 void writeString(std::string_view s, Sink & sink);
 
@@ -4,6 +4,7 @@
 #include "store-api.hh"
 #include "local-fs-store.hh"
 #include "progress-bar.hh"
+#include "schedule.hh"
 
 #include <nlohmann/json.hpp>
 
@@ -42,10 +43,17 @@ static nlohmann::json builtPathsWithResultToJSON(const std::vector<BuiltPathWith
     return res;
 }
 
+static std::string showDuration(std::chrono::seconds duration)
+{
+    auto s = duration.count();
+    return fmt("%d:%02d:%02d", s / 3600, (s / 60) % 60, s % 60);
+}
+
 struct CmdBuild : InstallablesCommand, MixDryRun, MixJSON, MixProfile
 {
     Path outLink = "result";
     bool printOutputPaths = false;
+    bool printSchedule = false;
     BuildMode buildMode = bmNormal;
 
     CmdBuild()
@@ -76,6 +84,12 @@ struct CmdBuild : InstallablesCommand, MixDryRun, MixJSON, MixProfile
             .description = "Rebuild an already built package and compare the result to the existing store paths.",
             .handler = {&buildMode, bmCheck},
         });
+
+        addFlag({
+            .longName = "print-schedule",
+            .description = "Do not build anything, but show when each derivation that needs to be built is expected to be built, based on previous build times, and how long the whole build is expected to take.",
+            .handler = {&printSchedule, true},
+        });
     }
 
     std::string description() override
@@ -107,6 +121,39 @@ struct CmdBuild : InstallablesCommand, MixDryRun, MixJSON, MixProfile
             return;
         }
 
+        if (printSchedule) {
+            std::vector<DerivedPath> pathsToBuild;
+
+            for (auto & i : installables)
+                for (auto & b : i->toDerivedPaths())
+                    pathsToBuild.push_back(b.path);
+
+            StorePathSet willBuild, willSubstitute, unknown;
+            uint64_t downloadSize, narSize;
+            store->queryMissing(pathsToBuild, willBuild, willSubstitute, unknown, downloadSize, narSize);
+
+            /* Build times are only recorded for builds done on this
+               machine. */
+            if (!store.dynamic_pointer_cast<LocalFSStore>())
+                warn("store '%s' is not local, so the schedule is based on the build times of this machine only", store->getUri());
+
+            auto schedule = computeSchedule(*store, willBuild, settings.maxBuildJobs);
+
+            stopProgressBar();
+
+            for (auto & entry : schedule.entries)
+                logger->cout("%s  %s  %s",
+                    showDuration(entry.start),
+                    showDuration(entry.end),
+                    store->printStorePath(entry.drvPath));
+
+            logger->cout("expected build time with %d jobs: %s",
+                settings.maxBuildJobs.get(),
+                showDuration(schedule.makespan));
+
+            return;
+        }
+
         auto buildables = Installable::build(
             getEvalStore(), store,
             Realise::Outputs,
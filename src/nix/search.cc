@@ -11,9 +11,15 @@
 #include "attr-path.hh"
 #include "hilite.hh"
 #include "strings-inline.hh"
+#include "eval-gc.hh"
+#include "processes.hh"
+#include "exit.hh"
+#include "file-system.hh"
+#include "finally.hh"
 
 #include <regex>
 #include <fstream>
+#include <variant>
 #include <nlohmann/json.hpp>
 
 #include "strings.hh"
@@ -30,6 +36,7 @@ struct CmdSearch : InstallableValueCommand, MixJSON
 {
     std::vector<std::string> res;
     std::vector<std::string> excludeRes;
+    unsigned int evalJobs = 1;
 
     CmdSearch()
     {
@@ -43,6 +50,13 @@ struct CmdSearch : InstallableValueCommand, MixJSON
                 excludeRes.push_back(s);
             }},
         });
+        addFlag({
+            .longName = "eval-jobs",
+            .description = "Evaluate the members of the package sets in *n* parallel processes.",
+            .labels = {"n"},
+            .handler = {&evalJobs},
+            .experimentalFeature = Xp::ParallelEval,
+        });
     }
 
     std::string description() override
@@ -92,6 +106,47 @@ struct CmdSearch : InstallableValueCommand, MixJSON
 
         uint64_t results = 0;
 
+        /* A matching package, in both output formats. */
+        struct Result
+        {
+            std::string attrPath;
+            nlohmann::json info;
+            std::string text;
+        };
+
+        auto printResult = [&](const Result & result)
+        {
+            results++;
+            if (json)
+                (*jsonOut)[result.attrPath] = result.info;
+            else {
+                if (results > 1) logger->cout("");
+                logger->cout("%s", result.text);
+            }
+        };
+
+        std::function<void(Result)> emit = printResult;
+
+        /* With `--eval-jobs`, the members of the top-level package sets
+           are not visited here but recorded in `pending`, in output
+           order, to be evaluated by worker processes. Results found
+           before that point are recorded in between. */
+        struct Task
+        {
+            ref<eval_cache::AttrCursor> cursor;
+            std::vector<Symbol> attrPath;
+        };
+
+        bool fanOut = evalJobs > 1;
+        std::vector<std::variant<Result, Task>> pending;
+
+        if (fanOut) {
+            /* The evaluation cache keeps a SQLite transaction open, which
+               can't be shared with forked processes. */
+            evalSettings.useEvalCache = false;
+            emit = [&](Result result) { pending.push_back(std::move(result)); };
+        }
+
         std::function<void(eval_cache::AttrCursor & cursor, const std::vector<Symbol> & attrPath, bool initialRecurse)> visit;
 
         visit = [&](eval_cache::AttrCursor & cursor, const std::vector<Symbol> & attrPath, bool initialRecurse)
@@ -103,14 +158,17 @@ struct CmdSearch : InstallableValueCommand, MixJSON
             try {
                 auto recurse = [&]()
                 {
+                    bool defer = fanOut && (initialRecurse || attrPath.size() >= 2);
                     for (const auto & attr : cursor.getAttrs()) {
                         auto cursor2 = cursor.getAttr(state->symbols[attr]);
                         auto attrPath2(attrPath);
                         attrPath2.push_back(attr);
-                        visit(*cursor2, attrPath2, false);
+                        if (defer)
+                            pending.push_back(Task{cursor2, std::move(attrPath2)});
+                        else
+                            visit(*cursor2, attrPath2, false);
                     }
                 };
-
                 if (cursor.isDerivation()) {
                     DrvName name(cursor.getAttr(state->sName)->getString());
 
@@ -153,23 +211,22 @@ struct CmdSearch : InstallableValueCommand, MixJSON
 
                     if (found)
                     {
-                        results++;
-                        if (json) {
-                            (*jsonOut)[attrPath2] = {
+                        auto text = fmt(
+                            "* %s%s",
+                            wrap("\e[0;1m", hiliteMatches(attrPath2, attrPathMatches, ANSI_GREEN, "\e[0;1m")),
+                            name.version != "" ? " (" + name.version + ")" : "");
+                        if (description != "")
+                            text += fmt(
+                                "\n  %s", hiliteMatches(description, descriptionMatches, ANSI_GREEN, ANSI_NORMAL));
+                        emit({
+                            .attrPath = attrPath2,
+                            .info = {
                                 {"pname", name.name},
                                 {"version", name.version},
                                 {"description", description},
-                            };
-                        } else {
-                            if (results > 1) logger->cout("");
-                            logger->cout(
-                                "* %s%s",
-                                wrap("\e[0;1m", hiliteMatches(attrPath2, attrPathMatches, ANSI_GREEN, "\e[0;1m")),
-                                name.version != "" ? " (" + name.version + ")" : "");
-                            if (description != "")
-                                logger->cout(
-                                    "  %s", hiliteMatches(description, descriptionMatches, ANSI_GREEN, ANSI_NORMAL));
-                        }
+                            },
+                            .text = std::move(text),
+                        });
                     }
                 }
 
@@ -197,6 +254,84 @@ struct CmdSearch : InstallableValueCommand, MixJSON
         for (auto & cursor : installable->getCursors(*state))
             visit(*cursor, cursor->getAttrPath(), true);
 
+        if (fanOut) {
+            std::vector<size_t> tasks;
+            for (auto [i, item] : enumerate(pending))
+                if (std::holds_alternative<Task>(item))
+                    tasks.push_back(i);
+
+            /* Each worker evaluates every `evalJobs`th task and writes
+               the results of each task, and the first task that failed,
+               to a file. */
+            auto tmpDir = createTempDir();
+            AutoDelete delTmpDir(tmpDir);
+
+            auto nrWorkers = std::min<size_t>(evalJobs, tasks.size());
+            std::vector<Pid> workers(nrWorkers);
+
+            /* The workers log to stderr directly. */
+            logger->pause();
+            Finally resumeLogger([]() { logger->resume(); });
+
+            for (size_t worker = 0; worker < nrWorkers; ++worker)
+                workers[worker] = startEvalProcess([&, worker]() {
+                    fanOut = false;
+                    if (verbosity > lvlWarn) verbosity = lvlWarn;
+
+                    auto out = json::object();
+                    auto & taskResults = out["results"] = json::object();
+                    int status = 0;
+
+                    for (size_t n = worker; n < tasks.size(); n += nrWorkers) {
+                        auto & task = std::get<Task>(pending[tasks[n]]);
+                        auto & resultsOut = taskResults[std::to_string(n)] = json::array();
+                        emit = [&](Result result) {
+                            resultsOut.push_back({result.attrPath, result.info, result.text});
+                        };
+                        try {
+                            visit(*task.cursor, task.attrPath, false);
+                        } catch (Error & e) {
+                            logError(e.info());
+                            out["failed"] = n;
+                            status = 1;
+                            break;
+                        }
+                    }
+
+                    writeFile(fmt("%s/%d.json", tmpDir, worker), out.dump());
+                    _exit(status);
+                });
+
+            std::vector<nlohmann::json> outputs;
+            for (auto [worker, pid] : enumerate(workers)) {
+                auto status = pid.wait();
+                auto path = fmt("%s/%d.json", tmpDir, worker);
+                if (!pathExists(path))
+                    throw Error("evaluation worker %s", statusToString(status));
+                outputs.push_back(nlohmann::json::parse(readFile(path)));
+            }
+
+            /* Print everything in the order a sequential search would
+               have, stopping at the first task that failed. */
+            size_t n = 0;
+            for (auto & item : pending) {
+                if (auto result = std::get_if<Result>(&item)) {
+                    printResult(*result);
+                    continue;
+                }
+                auto & output = outputs[n % nrWorkers];
+                if (output.contains("failed") && output["failed"] == n)
+                    throw Exit(1);
+                for (auto & r : output["results"][std::to_string(n)])
+                    printResult({
+                        .attrPath = r[0],
+                        .info = r[1],
+                        .text = r[2],
+                    });
+                n++;
+            }
+        }
+
         if (json)
             logger->cout("%s", *jsonOut);
 
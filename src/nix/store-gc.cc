@@ -19,6 +19,12 @@ struct CmdStoreGC : StoreCommand, MixDryRun
             .labels = {"n"},
             .handler = {&options.maxFreed}
         });
+
+        addFlag({
+            .longName = "incremental",
+            .description = "Only consider paths that may have become garbage since the last complete garbage collection.",
+            .handler = {&options.incremental, true}
+        });
     }
 
     std::string description() override
@@ -97,6 +97,26 @@ AuthorizationSettings authorizationSettings;
 
 static GlobalConfig::Register rSettings(&authorizationSettings);
 
+struct DaemonSettings : Config {
+
+    Setting<unsigned int> spareWorkers{
+        this, 0, "daemon-spare-workers",
+        R"(
+          The number of worker processes that the Nix daemon forks ahead of time.
+          A spare worker opens the Nix store and then waits for the daemon to hand it a client connection, so that new clients don't have to wait for a process to be forked and for the store to be opened.
+          Each connection is still handled by its own process, which exits when the client disconnects.
+
+          This only reduces the latency of new connections.
+          Spare workers are extra idle processes, each with its own open store and caches, so they increase the number of processes and the memory used by the daemon.
+
+          If set to `0`, a worker process is forked for each connection when the connection is accepted.
+        )"};
+};
+
+static DaemonSettings daemonSettings;
+
+static GlobalConfig::Register rDaemonSettings(&daemonSettings);
+
 #ifndef __linux__
 #define SPLICE_F_MOVE 0
 static ssize_t splice(int fd_in, void *off_in, int fd_out, void *off_out, size_t len, unsigned int flags)
@@ -283,6 +303,169 @@ static std::pair<TrustedFlag, std::string> authPeer(const PeerInfo & peer)
 }
 
 
+/**
+ * What a spare worker needs to know about the connection it is handed,
+ * besides the socket itself.
+ */
+struct Handoff
+{
+    TrustedFlag trusted;
+    bool pidKnown;
+    pid_t pid;
+};
+
+
+/**
+ * A worker process that has been forked ahead of time and has opened
+ * the store, and is waiting on `control` for a connection to handle.
+ */
+struct SpareWorker
+{
+    AutoCloseFD control;
+};
+
+
+/**
+ * Handle a connection in a worker process. Does not return.
+ */
+[[noreturn]] static void serveConnection(ref<Store> store, Descriptor remote, TrustedFlag trusted, bool pidKnown, pid_t pid)
+{
+    //  For debugging, stuff the pid into argv[1].
+    if (pidKnown && savedArgv[1]) {
+        auto processName = std::to_string(pid);
+        strncpy(savedArgv[1], processName.c_str(), strlen(savedArgv[1]));
+    }
+
+    //  Handle the connection.
+    processConnection(
+        store,
+        FdSource(remote),
+        FdSink(remote),
+        trusted,
+        NotRecursive);
+
+    exit(0);
+}
+
+
+static ProcessOptions workerProcessOptions()
+{
+    ProcessOptions options;
+    options.errorPrefix = "unexpected Nix daemon error: ";
+    options.dieWithParent = false;
+    options.runExitHandlers = true;
+    options.allowVfork = false;
+    return options;
+}
+
+
+/**
+ * Detach a freshly forked worker process from the daemon.
+ */
+static void initWorkerProcess()
+{
+    //  Background the daemon.
+    if (setsid() == -1)
+        throw SysError("creating a new session");
+
+    //  Restore normal handling of SIGCHLD.
+    setSigChldAction(false);
+}
+
+
+/**
+ * Fork a spare worker. `fdSocket` and `spares` are closed in the
+ * child.
+ */
+static SpareWorker startSpareWorker(AutoCloseFD & fdSocket, std::vector<SpareWorker> & spares)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1)
+        throw SysError("creating socket pair for spare worker");
+
+    SpareWorker spare{.control = AutoCloseFD(fds[0])};
+    AutoCloseFD child(fds[1]);
+
+    startProcess([&]() {
+        fdSocket = -1;
+        spares.clear();
+        spare.control = -1;
+
+        initWorkerProcess();
+
+        auto store = openUncachedStore();
+
+        Handoff handoff;
+        char cmsgBuf[CMSG_SPACE(sizeof(int))];
+        struct iovec iov { .iov_base = &handoff, .iov_len = sizeof(handoff) };
+        struct msghdr msg {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = cmsgBuf;
+        msg.msg_controllen = sizeof(cmsgBuf);
+
+        ssize_t n;
+        do {
+            n = recvmsg(child.get(), &msg, MSG_CMSG_CLOEXEC);
+        } while (n == -1 && errno == EINTR);
+
+        //  The daemon has shut down.
+        if (n == 0) exit(0);
+
+        if (n != sizeof(handoff))
+            throw SysError("receiving connection from the Nix daemon");
+
+        auto cmsg = CMSG_FIRSTHDR(&msg);
+        if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            throw Error("did not receive a connection from the Nix daemon");
+
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+        AutoCloseFD remote(fd);
+        child.close();
+
+        serveConnection(store, remote.get(), handoff.trusted, handoff.pidKnown, handoff.pid);
+    }, workerProcessOptions());
+
+    return spare;
+}
+
+
+/**
+ * Pass the connection `remote` to a spare worker.
+ *
+ * @return Whether a spare worker accepted the connection. This fails
+ * if the worker has exited, e.g. because it couldn't open the store.
+ */
+static bool handOffConnection(SpareWorker & spare, Descriptor remote, const Handoff & handoff)
+{
+    char cmsgBuf[CMSG_SPACE(sizeof(int))] = {};
+    struct iovec iov { .iov_base = (void *) &handoff, .iov_len = sizeof(handoff) };
+    struct msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsgBuf;
+    msg.msg_controllen = sizeof(cmsgBuf);
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &remote, sizeof(remote));
+
+    ssize_t n;
+    do {
+        n = sendmsg(spare.control.get(), &msg, MSG_NOSIGNAL);
+    } while (n == -1 && errno == EINTR);
+
+    if (n == sizeof(handoff))
+        return true;
+
+    debug("could not hand off connection to spare worker: %s", n == -1 ? strerror(errno) : "short write");
+    return false;
+}
+
+
 /**
  * Run a server. The loop opens a socket and accepts new connections from that
  * socket.
@@ -337,9 +520,21 @@ static void daemonLoop(std::optional<TrustedFlag> forceTrustClientOpt)
     }
     #endif
 
+    std::vector<SpareWorker> spares;
+
     //  Loop accepting connections.
     while (1) {
 
+        //  Replace the spare workers that have been handed connections.
+        while (spares.size() < daemonSettings.spareWorkers) {
+            try {
+                spares.push_back(startSpareWorker(fdSocket, spares));
+            } catch (Error & error) {
+                logError(error.info());
+                break;
+            }
+        }
+
         try {
             //  Accept a connection.
             struct sockaddr_un remoteAddr;
@@ -372,38 +567,25 @@ static void daemonLoop(std::optional<TrustedFlag> forceTrustClientOpt)
                 peer.pidKnown ? std::to_string(peer.pid) : "<unknown>",
                 peer.uidKnown ? user : "<unknown>");
 
+            //  Hand the connection to a spare worker, if we have one.
+            bool handedOff = false;
+            while (!handedOff && !spares.empty()) {
+                auto spare = std::move(spares.back());
+                spares.pop_back();
+                handedOff = handOffConnection(spare, remote.get(),
+                    Handoff { .trusted = trusted, .pidKnown = peer.pidKnown, .pid = peer.pid });
+            }
+            if (handedOff) continue;
+
             //  Fork a child to handle the connection.
-            ProcessOptions options;
-            options.errorPrefix = "unexpected Nix daemon error: ";
-            options.dieWithParent = false;
-            options.runExitHandlers = true;
-            options.allowVfork = false;
             startProcess([&]() {
                 fdSocket = -1;
+                spares.clear();
+
+                initWorkerProcess();
 
-                //  Background the daemon.
-                if (setsid() == -1)
-                    throw SysError("creating a new session");
-
-                //  Restore normal handling of SIGCHLD.
-                setSigChldAction(false);
-
-                //  For debugging, stuff the pid into argv[1].
-                if (peer.pidKnown && savedArgv[1]) {
-                    auto processName = std::to_string(peer.pid);
-                    strncpy(savedArgv[1], processName.c_str(), strlen(savedArgv[1]));
-                }
-
-                //  Handle the connection.
-                processConnection(
-                    openUncachedStore(),
-                    FdSource(remote.get()),
-                    FdSink(remote.get()),
-                    trusted,
-                    NotRecursive);
-
-                exit(0);
-            }, options);
+                serveConnection(openUncachedStore(), remote.get(), trusted, peer.pidKnown, peer.pid);
+            }, workerProcessOptions());
 
         } catch (Interrupted & e) {
             return;
@@ -252,6 +252,25 @@ diff -u \
     <(echo '{"version":1,"root":{"type":"directory","entries":{"bar":{"type":"regular","size":4,"narOffset":232},"link":{"type":"symlink","target":"xyzzy"}}}}' | jq -S)
 
 
+# Test reading single files from a NAR with seekable compression.
+clearCache
+clearCacheCache
+
+nix copy --to "file://$cacheDir?compression=zstd&seekable-compression=true&write-nar-listing=1" "$outPath"
+
+[[ $(nix store cat -vvvv --store "file://$cacheDir" "$outPath/bar" 2> "$TEST_ROOT/log") = foo ]]
+grepQuiet "using range requests" "$TEST_ROOT/log"
+
+# A cache that doesn't honour range requests is read in full.
+[[ $(_NIX_FORCE_HTTP=1 nix store cat -vvvv --store "file://$cacheDir" "$outPath/bar" 2> "$TEST_ROOT/log") = foo ]]
+grepQuiet "does not support range requests" "$TEST_ROOT/log"
+
+# So is a NAR with a malformed listing.
+echo '{' > "$cacheDir/$(basename "$outPath" | cut -c1-32).ls"
+[[ $(nix store cat --store "file://$cacheDir" "$outPath/bar" 2> "$TEST_ROOT/log") = foo ]]
+grepQuiet "ignoring malformed listing" "$TEST_ROOT/log"
+
+
 # Test debug info index generation.
 clearCache
 
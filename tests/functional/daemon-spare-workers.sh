@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+
+source common.sh
+
+requireDaemonNewerThan "2.26.0"
+
+TODO_NixOS
+
+[[ $(uname) == Linux ]] || skipTest "needs /proc to find the spare workers"
+
+# The worker processes of the daemon that aren't serving a client.
+daemonChildren() {
+    local stat pid ppid
+    for stat in /proc/[0-9]*/stat; do
+        read -r pid _ _ ppid _ < "$stat" 2> /dev/null || continue
+        if [[ $ppid == "$_NIX_TEST_DAEMON_PID" ]]; then echo "$pid"; fi
+    done
+}
+
+waitForSpares() {
+    for ((i = 0; i < 100; i++)); do
+        if [[ $(daemonChildren | wc -l) -eq 2 ]]; then return; fi
+        sleep 0.1
+    done
+    fail "the daemon doesn't have 2 spare workers"
+}
+
+clearStore
+
+echo 'daemon-spare-workers = 2' >> "$test_nix_conf"
+killDaemon
+startDaemon
+
+waitForSpares
+
+# Connections are handed to the spare workers, which are replaced.
+for i in {1..8}; do
+    echo "$i" > "$TEST_ROOT/spare-$i"
+    nix-store --add "$TEST_ROOT/spare-$i" > "$TEST_ROOT/spare-$i.path" &
+done
+wait
+for i in {1..8}; do
+    [[ $(cat "$(cat "$TEST_ROOT/spare-$i.path")") = "$i" ]]
+done
+
+waitForSpares
+
+# If the spare workers have died, the daemon forks a worker for the
+# connection instead.
+oldSpares=$(daemonChildren)
+# shellcheck disable=SC2086
+kill -9 $oldSpares
+nix store info
+
+waitForSpares
+newSpares=" $(daemonChildren | tr '\n' ' ') "
+for pid in $oldSpares; do
+    [[ $newSpares != *" $pid "* ]]
+done
+nix store info
+
+killDaemon
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+
+source common.sh
+
+TODO_NixOS
+
+clearStore
+
+root1=$(nix store add-path --name root1 ./nar-access.sh)
+root2=$(nix store add-path --name root2 ./nar-access.sh)
+garbage1=$(nix store add-path --name garbage1 ./nar-access.sh)
+
+ln -sf "$root1" "$NIX_STATE_DIR/gcroots/root1"
+ln -sf "$root2" "$NIX_STATE_DIR/gcroots/root2"
+
+# Without a previous complete collection, this is a full collection.
+nix store gc --incremental
+[[ -e $root1 ]]
+[[ -e $root2 ]]
+[[ ! -e $garbage1 ]]
+
+# Paths registered since the last collection are considered.
+garbage2=$(nix store add-path --name garbage2 ./nar-access.sh)
+nix store gc --incremental
+[[ ! -e $garbage2 ]]
+[[ -e $root1 ]]
+
+# So are paths that were reachable from roots that have disappeared.
+rm "$NIX_STATE_DIR/gcroots/root1"
+nix store gc --incremental
+[[ ! -e $root1 ]]
+[[ -e $root2 ]]
+
+# Paths that are reachable from the remaining roots are kept.
+nix store gc
+[[ -e $root2 ]]
@@ -31,6 +31,16 @@ NIX_REMOTE_=$NIX_REMOTE $SHELL ./user-envs-test-case.sh
 
 nix-store --gc --max-freed 1K
 
+# Closures are queried in batches through the daemon. This must give
+# the same result as querying the store directly.
+outPath=$(nix-build dependencies.nix --no-out-link)
+diff -u \
+    <(nix path-info --recursive --json "$outPath" | jq -S) \
+    <(NIX_REMOTE= nix path-info --recursive --json "$outPath" | jq -S)
+if isDaemonNewer "2.26.0"; then
+    nix path-info --recursive -vvvvv "$outPath" 2>&1 | grepQuiet "negotiated feature 'batched-queries'"
+fi
+
 nix-store --dump-db > $TEST_ROOT/d1
 NIX_REMOTE= nix-store --dump-db > $TEST_ROOT/d2
 cmp $TEST_ROOT/d1 $TEST_ROOT/d2
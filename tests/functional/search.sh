@@ -49,3 +49,12 @@ e=$'\x1b' # grep doesn't support \e, \033 or even \x1b
 (( $(nix search -f search.nix foo ^ --exclude 'foo|bar' | grep -Ec 'foo|bar') == 0 ))
 (( $(nix search -f search.nix foo ^ -e foo --exclude bar | grep -Ec 'foo|bar') == 0 ))
 [[ $(nix search -f search.nix '' ^ -e bar --json | jq -c 'keys') == '["foo","hello"]' ]]
+
+## Tests for --eval-jobs
+for args in "'' ^" "'' hello empty" "'' ^ -e bar"; do
+    eval "nix search -f search.nix $args" > "$TEST_ROOT/search-serial"
+    eval "nix search --extra-experimental-features parallel-eval -f search.nix $args --eval-jobs 2" > "$TEST_ROOT/search-parallel"
+    diff "$TEST_ROOT/search-serial" "$TEST_ROOT/search-parallel"
+done
+[[ $(nix search --extra-experimental-features parallel-eval -f search.nix '' ^ --eval-jobs 3 --json | jq -c 'keys') == '["bar","foo","hello"]' ]]
+expectStderr 1 nix search -f search.nix '' ^ --eval-jobs 2 | grepQuiet "experimental Nix feature 'parallel-eval' is disabled"
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+
+source common.sh
+
+needLocalStore "--verify needs a local store"
+
+TODO_NixOS
+
+clearStore
+
+path=$(nix-build dependencies.nix -o $TEST_ROOT/result)
+path2=$(nix-store -qR $path | grep input-2)
+
+# Both the link hashes and the store path hashes are checked.
+nix-store --optimise
+nix-store --verify --check-contents 2>&1 | tee $TEST_ROOT/verify.log
+grepQuiet "checking link hashes" $TEST_ROOT/verify.log
+grepQuiet "checking store hashes" $TEST_ROOT/verify.log
+
+# Corrupting a file through its link is reported for the link and for
+# every store path that contains it.
+link=$(find $NIX_STORE_DIR/.links -samefile $path2/bar)
+[[ -n $link ]]
+chmod u+w $link
+echo XXX > $link
+
+expectStderr 1 nix-store --verify --check-contents > $TEST_ROOT/verify.log
+grepQuiet "link '.*' was modified" $TEST_ROOT/verify.log
+grepQuiet "path '$path2' was modified" $TEST_ROOT/verify.log
+
+# Repairing removes the link and rebuilds the path.
+nix-store --verify --check-contents --repair
+[[ "BAR" = "$(< $path2/bar)" ]]
+nix-store --verify --check-contents